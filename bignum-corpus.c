@@ -0,0 +1,226 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+
+Binary corpus files, see bignum-corpus.h.
+
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bignum-corpus.h"
+
+
+static void _corpus_header(struct bn_corpus_header* h, uint64_t count);
+static int  _write_at(int fd, const void* data, size_t len, off_t offset);
+
+
+int bn_corpus_open(struct bn_corpus* c, const char* path)
+{
+  require(c, "c is null");
+  require(path, "path is null");
+
+  struct bn_corpus_header h;
+  struct stat st;
+
+  c->records = NULL;
+  c->count = 0;
+  c->map = NULL;
+  c->map_size = 0;
+
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    return BN_IO_ERROR;
+  }
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return BN_IO_ERROR;
+  }
+  if ((size_t)st.st_size < sizeof(h))
+  {
+    close(fd);
+    return BN_INVALID;
+  }
+
+  void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+  {
+    return BN_IO_ERROR;
+  }
+
+  /* Only the layout this build would have written is usable in place */
+  memcpy(&h, map, sizeof(h));
+  const uint64_t size = (uint64_t)st.st_size;
+  if (   (memcmp(h.magic, BN_CORPUS_MAGIC, sizeof(h.magic)) != 0)
+      || (h.version != BN_CORPUS_VERSION)
+      || (h.byte_order != BN_CORPUS_BYTEORDER)
+      || (h.word_size != WORD_SIZE)
+      || (h.nlimbs != BN_ARRAY_SIZE)
+      || (h.offset < sizeof(h))
+      || ((h.offset % BN_CORPUS_ALIGN) != 0)
+      || (h.offset > size)
+      || (h.count > (size - h.offset) / sizeof(struct bn)))
+  {
+    munmap(map, (size_t)st.st_size);
+    return BN_INVALID;
+  }
+
+#ifdef POSIX_MADV_WILLNEED
+  posix_madvise(map, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+#endif
+
+  c->records = (const struct bn*)((const char*)map + h.offset);
+  c->count = (size_t)h.count;
+  c->map = map;
+  c->map_size = (size_t)st.st_size;
+  return BN_OK;
+}
+
+
+void bn_corpus_close(struct bn_corpus* c)
+{
+  require(c, "c is null");
+
+  if (c->map)
+  {
+    munmap(c->map, c->map_size);
+  }
+  c->records = NULL;
+  c->count = 0;
+  c->map = NULL;
+  c->map_size = 0;
+}
+
+
+int bn_corpus_create(struct bn_corpus_writer* w, const char* path)
+{
+  require(w, "w is null");
+  require(path, "path is null");
+
+  w->count = 0;
+  w->status = BN_OK;
+  w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (w->fd < 0)
+  {
+    w->status = BN_IO_ERROR;
+  }
+  return w->status;
+}
+
+
+int bn_corpus_append(struct bn_corpus_writer* w, const struct bn* records, size_t count)
+{
+  require(w, "w is null");
+  require((records || (count == 0)), "records is null");
+
+  if (w->status == BN_OK)
+  {
+    const off_t offset = (off_t)(BN_CORPUS_ALIGN + (w->count * sizeof(struct bn)));
+    w->status = _write_at(w->fd, records, count * sizeof(struct bn), offset);
+    w->count += count;
+  }
+  return w->status;
+}
+
+
+int bn_corpus_finish(struct bn_corpus_writer* w)
+{
+  require(w, "w is null");
+
+  struct bn_corpus_header h;
+
+  /* The header goes last, so an interrupted write leaves no valid corpus behind */
+  if (w->status == BN_OK)
+  {
+    _corpus_header(&h, w->count);
+    w->status = _write_at(w->fd, &h, sizeof(h), 0);
+  }
+  if ((w->fd >= 0) && (close(w->fd) != 0) && (w->status == BN_OK))
+  {
+    w->status = BN_IO_ERROR;
+  }
+  w->fd = -1;
+  return w->status;
+}
+
+
+int bn_corpus_write(const char* path, const struct bn* records, size_t count)
+{
+  struct bn_corpus_writer w;
+
+  if (bn_corpus_create(&w, path) == BN_OK)
+  {
+    bn_corpus_append(&w, records, count);
+  }
+  return bn_corpus_finish(&w);
+}
+
+
+static void _corpus_header(struct bn_corpus_header* h, uint64_t count)
+{
+  require(sizeof(*h) <= BN_CORPUS_ALIGN, "header does not fit before the records");
+
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, BN_CORPUS_MAGIC, sizeof(h->magic));
+  h->version = BN_CORPUS_VERSION;
+  h->byte_order = BN_CORPUS_BYTEORDER;
+  h->word_size = WORD_SIZE;
+  h->nlimbs = BN_ARRAY_SIZE;
+  h->count = count;
+  h->offset = BN_CORPUS_ALIGN;
+}
+
+
+/* pwrite() until everything is out, retrying interrupted and partial writes */
+static int _write_at(int fd, const void* data, size_t len, off_t offset)
+{
+  const char* p = (const char*)data;
+  while (len > 0)
+  {
+    const ssize_t done = pwrite(fd, p, len, offset);
+    if (done < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return BN_IO_ERROR;
+    }
+    p += done;
+    len -= (size_t)done;
+    offset += done;
+  }
+  return BN_OK;
+}
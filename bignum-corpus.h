@@ -0,0 +1,97 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+#ifndef __BIGNUM_CORPUS_H__
+#define __BIGNUM_CORPUS_H__
+/*
+
+Binary corpus files: arrays of struct bn that are mapped and used in place.
+
+A corpus is a 64-byte header followed, at an aligned offset, by the limb
+arrays of its records exactly as they sit in memory. Opening one maps the
+file and checks that it was written with the same WORD_SIZE, BN_ARRAY_SIZE
+and byte order; the records are then plain `const struct bn*` and nothing is
+parsed. Files written by another configuration are refused rather than
+converted, regenerate them from text with tests/tool-bignum-corpus.
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bignum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BN_CORPUS_MAGIC     "BNCORPUS"
+#define BN_CORPUS_VERSION   1
+#define BN_CORPUS_BYTEORDER 0x01020304u  /* stored in host order, reads back differently on the other endianness */
+
+/* Offset of the first record, and of the records of later versions */
+#ifndef BN_CORPUS_ALIGN
+  #define BN_CORPUS_ALIGN 64
+#endif
+
+struct bn_corpus_header {
+  char     magic[8];      /* BN_CORPUS_MAGIC, not terminated */
+  uint32_t version;
+  uint32_t byte_order;    /* BN_CORPUS_BYTEORDER */
+  uint32_t word_size;     /* WORD_SIZE */
+  uint32_t nlimbs;        /* BN_ARRAY_SIZE, limbs per record */
+  uint64_t count;         /* number of records */
+  uint64_t offset;        /* of the first record, a multiple of BN_CORPUS_ALIGN */
+  uint8_t  reserved[24];  /* zero */
+};
+
+/* An open corpus */
+struct bn_corpus {
+  const struct bn* records;
+  size_t count;
+  void*  map;
+  size_t map_size;
+};
+
+/* Records written one batch at a time, the count is filled in by bn_corpus_finish() */
+struct bn_corpus_writer {
+  int fd;
+  uint64_t count;
+  int status;
+};
+
+int  bn_corpus_open(struct bn_corpus* c, const char* path);    /* BN_OK, BN_IO_ERROR, or BN_INVALID for a foreign or damaged file */
+void bn_corpus_close(struct bn_corpus* c);
+
+int  bn_corpus_create(struct bn_corpus_writer* w, const char* path);                     /* Truncates path: BN_OK or BN_IO_ERROR */
+int  bn_corpus_append(struct bn_corpus_writer* w, const struct bn* records, size_t count);
+int  bn_corpus_finish(struct bn_corpus_writer* w);                                       /* Writes the header and closes: BN_OK or BN_IO_ERROR */
+int  bn_corpus_write(const char* path, const struct bn* records, size_t count);          /* All three at once */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef __BIGNUM_CORPUS_H__ */
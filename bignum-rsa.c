@@ -0,0 +1,326 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+
+RSA key generation and the raw RSA operations - see bignum-rsa.h
+
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bignum-rsa.h"
+
+
+/* One prime search: the sieve over the candidates from a random start */
+struct _search
+{
+  struct bn_sieve sieve;
+  struct bn prime;
+  int nbits;
+  int done;
+};
+
+static int  _start_search(struct _search* s, int nbits, bn_random_fn rng, void* ctx);
+static int  _accept(const struct bn* p, const struct bn* e);
+static int  _seeded_random(void* ctx, uint8_t* buf, size_t len);
+
+
+int bn_rsa_keygen(struct bn_pool* pool, struct bn_rsa_key* key, int nbits, DTYPE_TMP e, bn_random_fn rng, void* ctx)
+{
+  require(key, "key is null");
+  require(rng, "rng is null");
+
+  struct bn cand[BN_POOL_MAX_THREADS + 1];
+  int res[BN_POOL_MAX_THREADS + 1];
+  int owner[BN_POOL_MAX_THREADS + 1];
+  int restart[2];
+  struct _search search[2];
+  struct bn pm1, qm1, g, t;
+  const int nthreads = (pool != NULL) ? pool->nthreads : 1;
+  int count, i, k, status;
+
+  if ((nbits < 16) || (nbits > BN_ARRAY_SIZE * WORD_SIZE * 8) || (e < 3) || ((e & 1) == 0))
+  {
+    return BN_INVALID;
+  }
+  bignum_from_int(&key->e, e);
+  key->nbits = nbits;
+
+  /* p gets the odd bit, so that p > q */
+  for (k = 0; k < 2; ++k)
+  {
+    status = _start_search(&search[k], (k == 0) ? (nbits + 1) / 2 : nbits / 2, rng, ctx);
+    if (status != BN_OK)
+    {
+      return status;
+    }
+  }
+
+  while (!search[0].done || !search[1].done)
+  {
+    /*
+      About one candidate per thread, taken one per unfinished search in turn as a
+      single-threaded run would. A search that runs past nbits bits only notes it:
+      the batch ends with that step, and the fresh random start waits for the results,
+      so that the random draws - and the key - do not depend on the number of threads.
+    */
+    count = 0;
+    restart[0] = restart[1] = 0;
+    while ((count < nthreads) && !restart[0] && !restart[1])
+    {
+      for (k = 0; k < 2; ++k)
+      {
+        if (!search[k].done)
+        {
+          if ((bignum_sieve_next(&search[k].sieve, &cand[count]) != BN_OK) || (bignum_nbits(&cand[count]) > search[k].nbits))
+          {
+            restart[k] = 1;
+          }
+          else
+          {
+            owner[count] = k;
+            count += 1;
+          }
+        }
+      }
+    }
+
+    bignum_is_probable_prime_many(pool, cand, res, count);
+
+    /* In candidate order, as a sequential search would */
+    for (i = 0; i < count; ++i)
+    {
+      k = owner[i];
+      if (!search[k].done && res[i] && _accept(&cand[i], &key->e))
+      {
+        bignum_assign(&search[k].prime, &cand[i]);
+        search[k].done = 1;
+      }
+    }
+
+    /* Ran past nbits bits without a prime: start over from a fresh random point */
+    for (k = 0; k < 2; ++k)
+    {
+      if (restart[k] && !search[k].done)
+      {
+        status = _start_search(&search[k], search[k].nbits, rng, ctx);
+        if (status != BN_OK)
+        {
+          return status;
+        }
+      }
+    }
+
+    /* Two equal primes: a fresh q */
+    if (search[0].done && search[1].done && (bignum_cmp(&search[0].prime, &search[1].prime) == EQUAL))
+    {
+      status = _start_search(&search[1], search[1].nbits, rng, ctx);
+      if (status != BN_OK)
+      {
+        return status;
+      }
+    }
+  }
+
+  bignum_assign(&key->p, &search[0].prime);
+  bignum_assign(&key->q, &search[1].prime);
+  if (bignum_cmp(&key->p, &key->q) == SMALLER)
+  {
+    bignum_assign(&t, &key->p);
+    bignum_assign(&key->p, &key->q);
+    bignum_assign(&key->q, &t);
+  }
+  bignum_mul(&key->p, &key->q, &key->n);
+
+  /* d = e^-1 mod lcm(p - 1, q - 1), which exists since gcd(e, p - 1) = gcd(e, q - 1) = 1 */
+  bignum_assign(&pm1, &key->p);
+  bignum_dec(&pm1);
+  bignum_assign(&qm1, &key->q);
+  bignum_dec(&qm1);
+  bignum_gcd(&pm1, &qm1, &g);
+  bignum_div(&pm1, &g, &t);
+  bignum_mul(&t, &qm1, &t);
+  status = bignum_modinv(&key->e, &t, &key->d);
+  require(status == BN_OK, "e not invertible");
+
+  bignum_mod(&key->d, &pm1, &key->dp);
+  bignum_mod(&key->d, &qm1, &key->dq);
+  status = bignum_modinv(&key->q, &key->p, &key->qinv);
+  require(status == BN_OK, "q not invertible");
+  return BN_OK;
+}
+
+
+int bn_rsa_keygen_seeded(struct bn_pool* pool, struct bn_rsa_key* key, int nbits, DTYPE_TMP e, uint64_t seed)
+{
+  return bn_rsa_keygen(pool, key, nbits, e, _seeded_random, &seed);
+}
+
+
+int bn_rsa_urandom(void* ctx, uint8_t* buf, size_t len)
+{
+  require((buf || (len == 0)), "buf is null");
+
+  const int fd = open("/dev/urandom", O_RDONLY);
+  size_t done = 0;
+
+  (void)ctx;
+  if (fd < 0)
+  {
+    return BN_IO_ERROR;
+  }
+  while (done < len)
+  {
+    const ssize_t got = read(fd, buf + done, len - done);
+    if (got <= 0)
+    {
+      if ((got < 0) && (errno == EINTR))
+      {
+        continue;
+      }
+      close(fd);
+      return BN_IO_ERROR;
+    }
+    done += (size_t)got;
+  }
+  close(fd);
+  return BN_OK;
+}
+
+
+void bn_rsa_public(const struct bn_rsa_key* key, const struct bn* m, struct bn* c)
+{
+  require(key, "key is null");
+  require(m, "m is null");
+  require(c, "c is null");
+
+  /* The usual public exponents fit a word and take the short path */
+  if (bignum_nbytes(&key->e) <= (int)sizeof(DTYPE_TMP))
+  {
+    DTYPE_TMP e = 0;
+    int i;
+    for (i = (int)(sizeof(DTYPE_TMP) / WORD_SIZE) - 1; i >= 0; --i)
+    {
+      e = (e << (8 * WORD_SIZE)) | key->e.array[i];
+    }
+    bignum_pow_mod_word(m, e, &key->n, c);
+  }
+  else
+  {
+    bignum_pow_mod(m, &key->e, &key->n, c);
+  }
+}
+
+
+void bn_rsa_private(const struct bn_rsa_key* key, const struct bn* c, struct bn* m)
+{
+  require(key, "key is null");
+  require(c, "c is null");
+  require(m, "m is null");
+
+  struct bn m1, m2, h;
+
+  /* m1 = c^dp mod p, m2 = c^dq mod q, m = m2 + q * (qinv * (m1 - m2) mod p) */
+  bignum_pow_mod(c, &key->dp, &key->p, &m1);
+  bignum_pow_mod(c, &key->dq, &key->q, &m2);
+  if (bignum_cmp(&m1, &m2) == SMALLER)
+  {
+    bignum_add(&m1, &key->p, &m1);
+  }
+  bignum_sub(&m1, &m2, &h);
+  bignum_mul(&h, &key->qinv, &h);
+  bignum_mod(&h, &key->p, &h);
+  bignum_mul(&h, &key->q, &h);
+  bignum_add(&h, &m2, m);
+}
+
+
+/* Random nbits-bit starting point with the top two bits set, candidates from there on */
+static int _start_search(struct _search* s, int nbits, bn_random_fn rng, void* ctx)
+{
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  uint8_t buf[BN_ARRAY_SIZE * WORD_SIZE];
+  const size_t nbytes = ((size_t)nbits + 7) / 8;
+  struct bn x;
+  int i, status;
+
+  status = rng(ctx, buf, nbytes);
+  if (status != BN_OK)
+  {
+    return status;
+  }
+  bignum_from_bytes_le(&x, buf, nbytes);
+  for (i = nbits; i < (int)nbytes * 8; ++i)
+  {
+    x.array[i / nbits_pr_word] &= (DTYPE)~((DTYPE)1 << (i % nbits_pr_word));
+  }
+  x.array[(nbits - 1) / nbits_pr_word] |= (DTYPE)1 << ((nbits - 1) % nbits_pr_word);
+  x.array[(nbits - 2) / nbits_pr_word] |= (DTYPE)1 << ((nbits - 2) % nbits_pr_word);
+
+  bignum_dec(&x);
+  bignum_sieve_init(&s->sieve, &x);
+  s->nbits = nbits;
+  s->done = 0;
+  return BN_OK;
+}
+
+
+/* A prime p is usable when e has an inverse modulo p - 1 */
+static int _accept(const struct bn* p, const struct bn* e)
+{
+  struct bn pm1, g;
+
+  bignum_assign(&pm1, p);
+  bignum_dec(&pm1);
+  bignum_gcd(e, &pm1, &g);
+  return (bignum_nbits(&g) == 1);
+}
+
+
+/* bn_random_fn of bn_rsa_keygen_seeded(): splitmix64, ctx is the 64-bit state */
+static int _seeded_random(void* ctx, uint8_t* buf, size_t len)
+{
+  uint64_t* state = ctx;
+  uint64_t z = 0;
+  size_t i;
+
+  for (i = 0; i < len; ++i)
+  {
+    if ((i % 8) == 0)
+    {
+      *state += 0x9e3779b97f4a7c15ULL;
+      z = *state;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      z = z ^ (z >> 31);
+    }
+    buf[i] = (uint8_t)(z >> (8 * (i % 8)));
+  }
+  return BN_OK;
+}
@@ -0,0 +1,83 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+#ifndef __BIGNUM_RSA_H__
+#define __BIGNUM_RSA_H__
+/*
+
+RSA key generation and the raw RSA operations.
+
+A key of nbits bits is the product of two primes p and q of half the bits each,
+with the top two bits set so that the product has exactly nbits bits. Each prime
+is the first number from a random starting point that is prime and has
+gcd(e, p - 1) = 1. The candidates come from bignum_sieve_next(). The survivors of
+both searches go to bignum_is_probable_prime() in batches, spread over a thread
+pool, and each search takes its first candidate that passes. That is the prime a
+single thread would have found, so a key depends only on the random bytes. The
+number of threads and their timing make no difference.
+
+bn_rsa_keygen_seeded() takes those bytes from a generator seeded by the caller,
+for reproducible benchmarks and tests. It is predictable by design: never use it
+for real keys.
+
+A key is made of struct bn only: no dynamic allocation.
+
+*/
+
+#include <stdint.h>
+
+#include "bignum.h"
+#include "bignum-thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct bn_rsa_key {
+  int nbits;
+  struct bn n;     /* p * q */
+  struct bn e;     /* public exponent */
+  struct bn d;     /* e^-1 mod lcm(p - 1, q - 1) */
+  struct bn p;     /* p > q */
+  struct bn q;
+  struct bn dp;    /* d mod (p - 1) */
+  struct bn dq;    /* d mod (q - 1) */
+  struct bn qinv;  /* q^-1 mod p */
+};
+
+/* Key generation: 16 <= nbits <= the bits of a struct bn, e odd and at least 3 (65537 as a rule). A NULL pool searches on the calling thread. */
+int  bn_rsa_keygen(struct bn_pool* pool, struct bn_rsa_key* key, int nbits, DTYPE_TMP e, bn_random_fn rng, void* ctx); /* BN_OK, BN_INVALID or rng's error */
+int  bn_rsa_keygen_seeded(struct bn_pool* pool, struct bn_rsa_key* key, int nbits, DTYPE_TMP e, uint64_t seed);       /* Same key for the same seed */
+int  bn_rsa_urandom(void* ctx, uint8_t* buf, size_t len);  /* bn_random_fn reading /dev/urandom, ctx unused: BN_OK or BN_IO_ERROR */
+
+/* Raw RSA on numbers below n */
+void bn_rsa_public(const struct bn_rsa_key* key, const struct bn* m, struct bn* c);   /* c = m^e mod n */
+void bn_rsa_private(const struct bn_rsa_key* key, const struct bn* c, struct bn* m);  /* m = c^d mod n, by the Chinese remainder theorem */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef __BIGNUM_RSA_H__ */
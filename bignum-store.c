@@ -0,0 +1,375 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+
+Compact storage for large numbers of mostly small values, see bignum-store.h.
+
+*/
+
+#include <string.h>
+
+#include "bignum-store.h"
+
+
+/* Header of a block, copied in and out of the first BN_STORE_HEADER_LIMBS limbs */
+struct _block
+{
+  uint32_t handle;  /* owner, _DEAD once the value moved elsewhere */
+  uint16_t cap;     /* limbs reserved */
+  uint16_t len;     /* significant limbs */
+};
+
+#define _DEAD 0xffffffffu
+
+static void _get_block(const struct bn_store* s, size_t offset, struct _block* b);
+static void _put_block(struct bn_store* s, size_t offset, const struct _block* b);
+static int  _reserve(struct bn_store* s, size_t nlimbs);
+static int  _append(struct bn_store* s, bn_handle h, const DTYPE* limbs, int len, int cap);
+static int  _place(struct bn_store* s, bn_handle h, const DTYPE* limbs, int len);
+static int  _significant(const DTYPE* limbs, int len);
+
+
+void bn_store_init(struct bn_store* s, DTYPE* arena, size_t arena_limbs, uint32_t* slots, size_t max_values)
+{
+  require(s, "s is null");
+  require((arena || (arena_limbs == 0)), "arena is null");
+  require((slots || (max_values == 0)), "slots is null");
+  require(BN_ARRAY_SIZE <= 0xffff, "BN_ARRAY_SIZE too large for 16-bit block lengths");
+  require(arena_limbs <= 0xffffffffu, "arena too large for 32-bit offsets");
+  require(max_values < _DEAD, "too many values for 32-bit handles");
+
+  s->arena = arena;
+  s->slots = slots;
+  s->arena_limbs = arena_limbs;
+  s->max_values = max_values;
+  s->used = 0;
+  s->garbage = 0;
+  s->count = 0;
+}
+
+
+int bn_store_add(struct bn_store* s, const struct bn* n, bn_handle* h)
+{
+  require(s, "s is null");
+  require(n, "n is null");
+  require(h, "h is null");
+
+  const int len = _significant(n->array, BN_ARRAY_SIZE);
+
+  if ((s->count == s->max_values) || (_reserve(s, BN_STORE_HEADER_LIMBS + len) != BN_OK))
+  {
+    return BN_OVERFLOW;
+  }
+
+  *h = (bn_handle)s->count;
+  s->count += 1;
+  return _append(s, *h, n->array, len, len);
+}
+
+
+int bn_store_set(struct bn_store* s, bn_handle h, const struct bn* n)
+{
+  require(s, "s is null");
+  require(n, "n is null");
+  require(h < s->count, "no such handle");
+
+  return _place(s, h, n->array, _significant(n->array, BN_ARRAY_SIZE));
+}
+
+
+void bn_store_load(const struct bn_store* s, bn_handle h, struct bn* n)
+{
+  require(s, "s is null");
+  require(n, "n is null");
+  require(h < s->count, "no such handle");
+
+  struct _block b;
+  _get_block(s, s->slots[h], &b);
+
+  bignum_init(n);
+  memcpy(n->array, &s->arena[s->slots[h] + BN_STORE_HEADER_LIMBS], b.len * sizeof(DTYPE));
+}
+
+
+int bn_store_nlimbs(const struct bn_store* s, bn_handle h)
+{
+  require(s, "s is null");
+  require(h < s->count, "no such handle");
+
+  struct _block b;
+  _get_block(s, s->slots[h], &b);
+  return b.len;
+}
+
+
+void bn_store_compact(struct bn_store* s)
+{
+  require(s, "s is null");
+
+  struct _block b;
+  size_t src = 0;
+  size_t dst = 0;
+
+  /* Blocks only ever move down, in arena order, so one pass suffices */
+  while (src < s->used)
+  {
+    _get_block(s, src, &b);
+    const size_t size = BN_STORE_HEADER_LIMBS + b.cap;
+    if (b.handle != _DEAD)
+    {
+      memmove(&s->arena[dst], &s->arena[src], (BN_STORE_HEADER_LIMBS + b.len) * sizeof(DTYPE));
+      b.cap = b.len;
+      _put_block(s, dst, &b);
+      s->slots[b.handle] = (uint32_t)dst;
+      dst += BN_STORE_HEADER_LIMBS + b.len;
+    }
+    src += size;
+  }
+
+  s->used = dst;
+  s->garbage = 0;
+}
+
+
+size_t bn_store_bytes(const struct bn_store* s)
+{
+  require(s, "s is null");
+
+  return (s->used * sizeof(DTYPE)) + (s->count * sizeof(uint32_t));
+}
+
+
+int bn_store_add_many(struct bn_store* s, const bn_handle* dst, const bn_handle* src, size_t count)
+{
+  require(s, "s is null");
+  require(((dst && src) || (count == 0)), "handles are null");
+
+  DTYPE t[BN_ARRAY_SIZE];
+  struct _block a, b;
+  DTYPE_TMP tmp;
+  size_t k;
+  int i;
+
+  for (k = 0; k < count; ++k)
+  {
+    require((dst[k] < s->count) && (src[k] < s->count), "no such handle");
+
+    _get_block(s, s->slots[dst[k]], &a);
+    _get_block(s, s->slots[src[k]], &b);
+    const DTYPE* x = &s->arena[s->slots[dst[k]] + BN_STORE_HEADER_LIMBS];
+    const DTYPE* y = &s->arena[s->slots[src[k]] + BN_STORE_HEADER_LIMBS];
+    int len = (a.len > b.len) ? a.len : b.len;
+
+    /* Only the significant limbs of the longer operand, plus a carry limb */
+    DTYPE carry = 0;
+    for (i = 0; i < len; ++i)
+    {
+      tmp = (DTYPE_TMP)((i < a.len) ? x[i] : 0) + ((i < b.len) ? y[i] : 0) + carry;
+      t[i] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> (8 * WORD_SIZE));
+    }
+    if (carry && (len < BN_ARRAY_SIZE))
+    {
+      t[len++] = carry;
+    }
+
+    if (_place(s, dst[k], t, _significant(t, len)) != BN_OK)
+    {
+      return BN_OVERFLOW;
+    }
+  }
+
+  return BN_OK;
+}
+
+
+int bn_store_sub_many(struct bn_store* s, const bn_handle* dst, const bn_handle* src, size_t count)
+{
+  require(s, "s is null");
+  require(((dst && src) || (count == 0)), "handles are null");
+
+  DTYPE t[BN_ARRAY_SIZE];
+  struct _block a, b;
+  DTYPE_TMP tmp;
+  size_t k;
+  int i;
+
+  for (k = 0; k < count; ++k)
+  {
+    require((dst[k] < s->count) && (src[k] < s->count), "no such handle");
+
+    _get_block(s, s->slots[dst[k]], &a);
+    _get_block(s, s->slots[src[k]], &b);
+    const DTYPE* x = &s->arena[s->slots[dst[k]] + BN_STORE_HEADER_LIMBS];
+    const DTYPE* y = &s->arena[s->slots[src[k]] + BN_STORE_HEADER_LIMBS];
+    int len = (a.len > b.len) ? a.len : b.len;
+
+    DTYPE borrow = 0;
+    for (i = 0; i < len; ++i)
+    {
+      tmp = (DTYPE_TMP)((i < a.len) ? x[i] : 0) - ((i < b.len) ? y[i] : 0) - borrow;
+      t[i] = (DTYPE)tmp;
+      borrow = (tmp > MAX_VAL);
+    }
+
+    /* Wrapped around: the upper limbs of the full-width result are all ones, as with bignum_sub() */
+    if (borrow)
+    {
+      for (; len < BN_ARRAY_SIZE; ++len)
+      {
+        t[len] = MAX_VAL;
+      }
+    }
+
+    if (_place(s, dst[k], t, _significant(t, len)) != BN_OK)
+    {
+      return BN_OVERFLOW;
+    }
+  }
+
+  return BN_OK;
+}
+
+
+void bn_store_sum(const struct bn_store* s, const bn_handle* h, size_t count, struct bn* total)
+{
+  require(s, "s is null");
+  require((h || (count == 0)), "h is null");
+  require(total, "total is null");
+
+  struct _block b;
+  DTYPE_TMP tmp;
+  size_t k;
+  int i;
+
+  bignum_init(total);
+  for (k = 0; k < count; ++k)
+  {
+    require(h[k] < s->count, "no such handle");
+
+    _get_block(s, s->slots[h[k]], &b);
+    const DTYPE* x = &s->arena[s->slots[h[k]] + BN_STORE_HEADER_LIMBS];
+
+    DTYPE carry = 0;
+    for (i = 0; i < b.len; ++i)
+    {
+      tmp = (DTYPE_TMP)total->array[i] + x[i] + carry;
+      total->array[i] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> (8 * WORD_SIZE));
+    }
+    for (; carry && (i < BN_ARRAY_SIZE); ++i)
+    {
+      total->array[i] += 1;
+      carry = (total->array[i] == 0);
+    }
+  }
+}
+
+
+static void _get_block(const struct bn_store* s, size_t offset, struct _block* b)
+{
+  memcpy(b, &s->arena[offset], sizeof(*b));
+}
+
+
+static void _put_block(struct bn_store* s, size_t offset, const struct _block* b)
+{
+  memcpy(&s->arena[offset], b, sizeof(*b));
+}
+
+
+/* Room for nlimbs more at the end of the arena, compacting if that makes enough */
+static int _reserve(struct bn_store* s, size_t nlimbs)
+{
+  if (s->used + nlimbs <= s->arena_limbs)
+  {
+    return BN_OK;
+  }
+  if (s->used - s->garbage + nlimbs > s->arena_limbs)
+  {
+    return BN_OVERFLOW;
+  }
+  bn_store_compact(s);
+  return BN_OK;
+}
+
+
+/* New block for h at the end of the arena; the caller made room */
+static int _append(struct bn_store* s, bn_handle h, const DTYPE* limbs, int len, int cap)
+{
+  struct _block b;
+  b.handle = h;
+  b.cap = (uint16_t)cap;
+  b.len = (uint16_t)len;
+
+  _put_block(s, s->used, &b);
+  memcpy(&s->arena[s->used + BN_STORE_HEADER_LIMBS], limbs, len * sizeof(DTYPE));
+  s->slots[h] = (uint32_t)s->used;
+  s->used += BN_STORE_HEADER_LIMBS + cap;
+  s->garbage += cap - len;
+  return BN_OK;
+}
+
+
+/* Value of h = the len limbs at limbs: in place if they fit its block, else in a new one with a spare limb */
+static int _place(struct bn_store* s, bn_handle h, const DTYPE* limbs, int len)
+{
+  struct _block b;
+  _get_block(s, s->slots[h], &b);
+
+  if (len <= b.cap)
+  {
+    memmove(&s->arena[s->slots[h] + BN_STORE_HEADER_LIMBS], limbs, len * sizeof(DTYPE));
+    s->garbage = s->garbage + b.len - len;
+    b.len = (uint16_t)len;
+    _put_block(s, s->slots[h], &b);
+    return BN_OK;
+  }
+
+  const int cap = (len < BN_ARRAY_SIZE) ? (len + 1) : len;
+  if (_reserve(s, BN_STORE_HEADER_LIMBS + cap) != BN_OK)
+  {
+    return BN_OVERFLOW;
+  }
+
+  /* Compaction may have moved the old block: kill it where it is now */
+  _get_block(s, s->slots[h], &b);
+  s->garbage += BN_STORE_HEADER_LIMBS + b.len;
+  b.handle = _DEAD;
+  _put_block(s, s->slots[h], &b);
+
+  return _append(s, h, limbs, len, cap);
+}
+
+
+/* Number of limbs up to the most significant nonzero one */
+static int _significant(const DTYPE* limbs, int len)
+{
+  while ((len > 0) && (limbs[len - 1] == 0))
+  {
+    len -= 1;
+  }
+  return len;
+}
@@ -0,0 +1,91 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+#ifndef __BIGNUM_STORE_H__
+#define __BIGNUM_STORE_H__
+/*
+
+Compact storage for large numbers of mostly small values.
+
+A struct bn always takes BN_ARRAY_SIZE limbs. A store keeps only the
+significant limbs of each value, in a block of an arena: a short header
+(owner handle, capacity and length) followed by the limbs. Values are
+named by handles, small integers that stay valid while values grow, move
+and the arena is compacted; a table maps each handle to its block.
+
+A value that outgrows its block moves to the end of the arena and leaves a
+dead block behind. Compaction slides the live blocks down over the dead
+ones and trims spare capacity; it runs by itself when the arena fills up.
+
+Like struct bn_pool, a store allocates nothing: the arena and the handle
+table are memory supplied by the caller.
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bignum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Limbs taken by the header of each block */
+#define BN_STORE_HEADER_LIMBS ((8 + WORD_SIZE - 1) / WORD_SIZE)
+
+/* Arena size for count values of up to nlimbs significant limbs each */
+#define BN_STORE_ARENA_LIMBS(count, nlimbs) ((count) * (BN_STORE_HEADER_LIMBS + (nlimbs)))
+
+typedef uint32_t bn_handle;
+
+struct bn_store {
+  DTYPE*    arena;        /* blocks of BN_STORE_HEADER_LIMBS + capacity limbs */
+  uint32_t* slots;        /* arena offset of the block of each handle */
+  size_t    arena_limbs;
+  size_t    max_values;
+  size_t    used;         /* limbs of the arena holding blocks, live or dead */
+  size_t    garbage;      /* limbs of dead blocks and spare capacity, freed by compaction */
+  size_t    count;        /* handles given out, 0 .. count - 1 */
+};
+
+void   bn_store_init(struct bn_store* s, DTYPE* arena, size_t arena_limbs, uint32_t* slots, size_t max_values);
+int    bn_store_add(struct bn_store* s, const struct bn* n, bn_handle* h);      /* New value: BN_OK, or BN_OVERFLOW when full */
+int    bn_store_set(struct bn_store* s, bn_handle h, const struct bn* n);       /* BN_OK, or BN_OVERFLOW (value unchanged) */
+void   bn_store_load(const struct bn_store* s, bn_handle h, struct bn* n);
+int    bn_store_nlimbs(const struct bn_store* s, bn_handle h);                  /* Significant limbs, 0 for zero */
+void   bn_store_compact(struct bn_store* s);
+size_t bn_store_bytes(const struct bn_store* s);                                /* Arena and handle table in use */
+
+/* Batches on the compact form, results truncated like bignum_add() / bignum_sub(); BN_OK, or BN_OVERFLOW at the first value that does not fit */
+int    bn_store_add_many(struct bn_store* s, const bn_handle* dst, const bn_handle* src, size_t count);   /* dst[i] += src[i] */
+int    bn_store_sub_many(struct bn_store* s, const bn_handle* dst, const bn_handle* src, size_t count);   /* dst[i] -= src[i] */
+void   bn_store_sum(const struct bn_store* s, const bn_handle* h, size_t count, struct bn* total);        /* total = sum of the values */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef __BIGNUM_STORE_H__ */
@@ -0,0 +1,427 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+/*
+
+Streaming operations on numbers far larger than a struct bn - see bignum-stream.h
+
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bignum-stream.h"
+
+
+static void _reduce_step(const struct bn_reducer* r, struct bn* acc, DTYPE_TMP mult, DTYPE add);
+static int  _digit_value(uint8_t c);
+
+/* Output buffering of bn_write_decimal_fd() */
+struct _fd_writer
+{
+  int fd;
+  int fill;
+  char buf[BN_STREAM_BUFSIZE];
+};
+static int  _write_all(int fd, const char* text, size_t len);
+static int  _fd_write(void* ctx, const char* text, int len);
+static int  _stdio_write(void* ctx, const char* text, int len);
+
+
+void bn_reducer_init(struct bn_reducer* r, const struct bn* m, int base)
+{
+  require(r, "r is null");
+  require(m, "m is null");
+  require(!bignum_is_zero(m), "modulus is zero");
+  require((((base >= 2) && (base <= 36)) || (base == BN_REDUCER_BYTES)), "base must be 2 to 36 or BN_REDUCER_BYTES");
+
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  int i;
+
+  bignum_assign(&r->m, m);
+  bignum_init(&r->acc);
+  r->base = base;
+  r->pending = 0;
+  r->npending = 0;
+  r->status = BN_OK;
+
+  r->nlimbs = BN_ARRAY_SIZE;
+  while ((r->nlimbs > 1) && (m->array[r->nlimbs - 1] == 0))
+  {
+    r->nlimbs -= 1;
+  }
+
+  /* Normalized divisor for the quotient estimates of _reduce_step() */
+  r->shift = 0;
+  while ((((DTYPE_TMP)m->array[r->nlimbs - 1] << r->shift) & DTYPE_MSB) == 0)
+  {
+    r->shift += 1;
+  }
+  for (i = r->nlimbs - 1; i > 0; --i)
+  {
+    r->v[i] = (DTYPE)(((DTYPE_TMP)m->array[i] << r->shift) | ((DTYPE_TMP)m->array[i - 1] >> (nbits_pr_word - r->shift)));
+  }
+  r->v[0] = (DTYPE)((DTYPE_TMP)m->array[0] << r->shift);
+
+  /* As many digits per chunk as keep base^k within a limb's range */
+  r->chunk_scale = base;
+  r->chunk_digits = 1;
+  while (r->chunk_scale * base <= (MAX_VAL + 1))
+  {
+    r->chunk_scale *= base;
+    r->chunk_digits += 1;
+  }
+}
+
+
+int bn_reducer_feed(struct bn_reducer* r, const void* data, size_t len)
+{
+  require(r, "r is null");
+  require((data || (len == 0)), "data is null");
+
+  const uint8_t* p = (const uint8_t*)data;
+  DTYPE_TMP pending = r->pending;
+  int npending = r->npending;
+  size_t i;
+
+  if (r->status != BN_OK)
+  {
+    return r->status;
+  }
+
+  for (i = 0; i < len; ++i)
+  {
+    int value;
+    if (r->base == BN_REDUCER_BYTES)
+    {
+      value = p[i];
+    }
+    else
+    {
+      if ((p[i] == ' ') || (p[i] == '\t') || (p[i] == '\n') || (p[i] == '\r'))
+      {
+        continue;
+      }
+      value = _digit_value(p[i]);
+      if (value >= r->base)
+      {
+        r->status = BN_INVALID;
+        break;
+      }
+    }
+
+    pending = (pending * r->base) + value;
+    npending += 1;
+    if (npending == r->chunk_digits)
+    {
+      _reduce_step(r, &r->acc, r->chunk_scale, (DTYPE)pending);
+      pending = 0;
+      npending = 0;
+    }
+  }
+
+  r->pending = (DTYPE)pending;
+  r->npending = npending;
+  return r->status;
+}
+
+
+int bn_reducer_feed_fd(struct bn_reducer* r, int fd)
+{
+  require(r, "r is null");
+
+  uint8_t buf[BN_STREAM_BUFSIZE];
+
+  while (r->status == BN_OK)
+  {
+    const ssize_t got = read(fd, buf, sizeof(buf));
+    if (got < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return BN_IO_ERROR;
+    }
+    if (got == 0)
+    {
+      break;
+    }
+    bn_reducer_feed(r, buf, (size_t)got);
+  }
+
+  return r->status;
+}
+
+
+int bn_reducer_feed_file(struct bn_reducer* r, const char* path)
+{
+  require(r, "r is null");
+  require(path, "path is null");
+
+  struct stat st;
+  int status;
+
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    return BN_IO_ERROR;
+  }
+
+  /* Map regular files in one piece, read everything else */
+  void* map = MAP_FAILED;
+  if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && (st.st_size > 0))
+  {
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  if (map != MAP_FAILED)
+  {
+#ifdef POSIX_MADV_SEQUENTIAL
+    posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+    status = bn_reducer_feed(r, map, (size_t)st.st_size);
+    munmap(map, (size_t)st.st_size);
+  }
+  else
+  {
+    status = bn_reducer_feed_fd(r, fd);
+  }
+
+  close(fd);
+  return status;
+}
+
+
+int bn_reducer_result(const struct bn_reducer* r, struct bn* res)
+{
+  require(r, "r is null");
+  require(res, "res is null");
+
+  bignum_assign(res, &r->acc);
+
+  /* The incomplete chunk, without disturbing the reducer */
+  if (r->npending > 0)
+  {
+    DTYPE_TMP mult = 1;
+    int i;
+    for (i = 0; i < r->npending; ++i)
+    {
+      mult *= r->base;
+    }
+    _reduce_step(r, res, mult, r->pending);
+  }
+
+  return r->status;
+}
+
+
+int bn_write_decimal_fd(const struct bn* n, int fd)
+{
+  require(n, "n is null");
+
+  struct _fd_writer w;
+  w.fd = fd;
+  w.fill = 0;
+
+  const int len = bignum_write_decimal(n, _fd_write, &w);
+  if (len < 0)
+  {
+    return len;
+  }
+  if (_write_all(fd, w.buf, (size_t)w.fill) != BN_OK)
+  {
+    return BN_IO_ERROR;
+  }
+  return len;
+}
+
+
+int bn_write_decimal_stdio(const struct bn* n, FILE* f)
+{
+  require(n, "n is null");
+  require(f, "f is null");
+
+  return bignum_write_decimal(n, _stdio_write, f);
+}
+
+
+/*
+  acc = (acc * mult + add) mod m, for acc < m and mult <= 2^(8 * WORD_SIZE).
+  The product is less than m * 2^(8 * WORD_SIZE), so one step of long division
+  (Knuth's algorithm D with a single quotient limb) reduces it.
+*/
+static void _reduce_step(const struct bn_reducer* r, struct bn* acc, DTYPE_TMP mult, DTYPE add)
+{
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  const int n = r->nlimbs;
+  const int s = r->shift;
+  const DTYPE* v = r->v;
+  DTYPE t[BN_ARRAY_SIZE + 1];
+  DTYPE u[BN_ARRAY_SIZE + 1];
+  DTYPE_TMP tmp, carry, qhat, rhat, prod;
+  DTYPE borrow;
+  int i;
+
+  if (n == 1)
+  {
+    acc->array[0] = (DTYPE)((((DTYPE_TMP)acc->array[0] * mult) + add) % r->m.array[0]);
+    return;
+  }
+
+  /* t = acc * mult + add, n + 1 limbs */
+  carry = add;
+  for (i = 0; i < n; ++i)
+  {
+    tmp = ((DTYPE_TMP)acc->array[i] * mult) + carry;
+    t[i] = (DTYPE)tmp;
+    carry = (tmp >> nbits_pr_word);
+  }
+  t[n] = (DTYPE)carry;
+
+  /* u = t shifted like v; still n + 1 limbs since t < m * 2^(8 * WORD_SIZE) */
+  for (i = n; i > 0; --i)
+  {
+    u[i] = (DTYPE)(((DTYPE_TMP)t[i] << s) | ((DTYPE_TMP)t[i - 1] >> (nbits_pr_word - s)));
+  }
+  u[0] = (DTYPE)((DTYPE_TMP)t[0] << s);
+
+  /* Estimate the quotient limb from the top two limbs, refine it with the third */
+  tmp = ((DTYPE_TMP)u[n] << nbits_pr_word) | u[n - 1];
+  qhat = tmp / v[n - 1];
+  rhat = tmp % v[n - 1];
+  while ((qhat > MAX_VAL) || ((qhat * v[n - 2]) > ((rhat << nbits_pr_word) | u[n - 2])))
+  {
+    qhat -= 1;
+    rhat += v[n - 1];
+    if (rhat > MAX_VAL)
+    {
+      break;
+    }
+  }
+
+  /* u -= qhat * v, adding v back if the estimate was still one too large */
+  carry = 0;
+  borrow = 0;
+  for (i = 0; i < n; ++i)
+  {
+    prod = (qhat * v[i]) + carry;
+    carry = (prod >> nbits_pr_word);
+    tmp = (DTYPE_TMP)u[i] - (DTYPE)prod - borrow;
+    u[i] = (DTYPE)tmp;
+    borrow = (tmp > MAX_VAL);
+  }
+  tmp = (DTYPE_TMP)u[n] - carry - borrow;
+  if (tmp > MAX_VAL)
+  {
+    carry = 0;
+    for (i = 0; i < n; ++i)
+    {
+      tmp = (DTYPE_TMP)u[i] + v[i] + carry;
+      u[i] = (DTYPE)tmp;
+      carry = (tmp >> nbits_pr_word);
+    }
+  }
+
+  /* Undo the normalization */
+  for (i = 0; i < n - 1; ++i)
+  {
+    acc->array[i] = (DTYPE)(((DTYPE_TMP)u[i] >> s) | ((DTYPE_TMP)u[i + 1] << (nbits_pr_word - s)));
+  }
+  acc->array[n - 1] = (DTYPE)((DTYPE_TMP)u[n - 1] >> s);
+}
+
+
+/* Value of a digit in bases up to 36, either case; 36 or more for anything else */
+static int _digit_value(uint8_t c)
+{
+  if ((c >= '0') && (c <= '9'))
+  {
+    return c - '0';
+  }
+  if ((c >= 'a') && (c <= 'z'))
+  {
+    return c - 'a' + 10;
+  }
+  if ((c >= 'A') && (c <= 'Z'))
+  {
+    return c - 'A' + 10;
+  }
+  return 255;
+}
+
+
+/* write() until everything is out, retrying interrupted and partial writes */
+static int _write_all(int fd, const char* text, size_t len)
+{
+  while (len > 0)
+  {
+    const ssize_t done = write(fd, text, len);
+    if (done < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return BN_IO_ERROR;
+    }
+    text += done;
+    len -= (size_t)done;
+  }
+  return BN_OK;
+}
+
+
+static int _fd_write(void* ctx, const char* text, int len)
+{
+  struct _fd_writer* w = (struct _fd_writer*)ctx;
+
+  if (w->fill + len > (int)sizeof(w->buf))
+  {
+    if (_write_all(w->fd, w->buf, (size_t)w->fill) != BN_OK)
+    {
+      return BN_IO_ERROR;
+    }
+    w->fill = 0;
+  }
+  if (len > (int)sizeof(w->buf))
+  {
+    return _write_all(w->fd, text, (size_t)len);
+  }
+  memcpy(&w->buf[w->fill], text, (size_t)len);
+  w->fill += len;
+  return BN_OK;
+}
+
+
+static int _stdio_write(void* ctx, const char* text, int len)
+{
+  return (fwrite(text, 1, (size_t)len, (FILE*)ctx) == (size_t)len) ? BN_OK : BN_IO_ERROR;
+}
@@ -0,0 +1,90 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+#ifndef __BIGNUM_STREAM_H__
+#define __BIGNUM_STREAM_H__
+/*
+
+Streaming operations on numbers far larger than a struct bn.
+
+A reducer computes X mod m for a number X that is fed in pieces, as text in
+any base from 2 to 36 or as raw big-endian bytes, by Horner's rule: every
+chunk of digits that fits a limb turns the residue r into r * base^k + chunk,
+reduced with a single quotient limb. Memory use is constant, whatever the
+length of X; a 100 MB decimal dump takes one pass over the data.
+
+The writers go the other way: they print a number in decimal straight to a
+file descriptor or a FILE*, block by block as bignum_write_decimal() produces
+the digits, without a buffer for the whole text.
+
+*/
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "bignum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size of the on-stack buffers of bn_reducer_feed_fd() and bn_write_decimal_fd() */
+#ifndef BN_STREAM_BUFSIZE
+  #define BN_STREAM_BUFSIZE 65536
+#endif
+
+/* Raw big-endian bytes instead of digits */
+#define BN_REDUCER_BYTES 256
+
+struct bn_reducer {
+  struct bn m;             /* modulus */
+  struct bn acc;           /* value of the complete chunks fed so far, mod m */
+  DTYPE v[BN_ARRAY_SIZE];  /* m shifted left until its top bit is set */
+  int nlimbs;              /* significant limbs of m */
+  int shift;               /* bits between m and v */
+  int base;                /* 2 .. 36, or BN_REDUCER_BYTES */
+  int chunk_digits;        /* digits per chunk */
+  DTYPE_TMP chunk_scale;   /* base^chunk_digits, at most 2^(8 * WORD_SIZE) */
+  DTYPE pending;           /* value of the digits of the incomplete chunk */
+  int npending;
+  int status;              /* BN_OK, or BN_INVALID once a bad character was fed */
+};
+
+/* Digits are case-insensitive, and spaces, tabs and line breaks between them are skipped. */
+void bn_reducer_init(struct bn_reducer* r, const struct bn* m, int base);   /* base 2 .. 36 or BN_REDUCER_BYTES */
+int  bn_reducer_feed(struct bn_reducer* r, const void* data, size_t len);   /* Returns BN_OK or BN_INVALID */
+int  bn_reducer_feed_fd(struct bn_reducer* r, int fd);                      /* Reads until end of file: BN_OK, BN_INVALID or BN_IO_ERROR */
+int  bn_reducer_feed_file(struct bn_reducer* r, const char* path);          /* Maps the file, or reads it when that fails */
+int  bn_reducer_result(const struct bn_reducer* r, struct bn* res);         /* res = everything fed so far mod m, returns the status */
+
+/* Decimal digits of n, without a terminator: return their number, or BN_IO_ERROR */
+int  bn_write_decimal_fd(const struct bn* n, int fd);
+int  bn_write_decimal_stdio(const struct bn* n, FILE* f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef __BIGNUM_STREAM_H__ */
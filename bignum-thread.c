@@ -0,0 +1,511 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+/*
+
+Thread pool for bignum operations - see bignum-thread.h
+
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <unistd.h>
+
+#include "bignum-thread.h"
+
+
+static void* _worker_main(void* arg);
+static void  _run_batch(struct bn_worker* self);
+static int   _take_job(struct bn_worker* self, size_t* index);
+static int   _steal_jobs(struct bn_worker* self);
+static int   _nlimbs(const struct bn* a);
+
+
+/* Public / Exported functions. */
+int bn_pool_init(struct bn_pool* pool, int nthreads)
+{
+  require(pool, "pool is null");
+
+  if (nthreads <= 0)
+  {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    nthreads = (ncpu > 0) ? (int)ncpu : 1;
+  }
+  if (nthreads > BN_POOL_MAX_THREADS)
+  {
+    nthreads = BN_POOL_MAX_THREADS;
+  }
+
+  pool->nthreads = nthreads;
+  pool->mul_threshold = BN_MUL_PARALLEL_THRESHOLD;
+  pool->generation = 0;
+  pool->active = 0;
+  pool->shutdown = 0;
+  pool->fn = NULL;
+  pool->ctx = NULL;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  int i;
+  for (i = 0; i < nthreads; ++i)
+  {
+    struct bn_worker* w = &pool->workers[i];
+    w->pool = pool;
+    w->id = i;
+    w->next = 0;
+    w->end = 0;
+    pthread_mutex_init(&w->lock, NULL);
+  }
+
+  /* Worker 0 is the thread calling bn_pool_run() */
+  for (i = 1; i < nthreads; ++i)
+  {
+    if (pthread_create(&pool->workers[i].thread, NULL, _worker_main, &pool->workers[i]) != 0)
+    {
+      /* Keep the threads that did start */
+      pool->nthreads = i;
+      break;
+    }
+  }
+
+  return (pool->nthreads == nthreads) ? 0 : -1;
+}
+
+
+void bn_pool_destroy(struct bn_pool* pool)
+{
+  require(pool, "pool is null");
+
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  int i;
+  for (i = 1; i < pool->nthreads; ++i)
+  {
+    pthread_join(pool->workers[i].thread, NULL);
+  }
+  for (i = 0; i < pool->nthreads; ++i)
+  {
+    pthread_mutex_destroy(&pool->workers[i].lock);
+  }
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->start);
+  pthread_mutex_destroy(&pool->lock);
+}
+
+
+void bn_pool_run(struct bn_pool* pool, size_t count, bn_task_fn fn, void* ctx)
+{
+  require(fn, "fn is null");
+
+  size_t i;
+  if ((pool == NULL) || (pool->nthreads == 1) || (count < 2))
+  {
+    for (i = 0; i < count; ++i)
+    {
+      fn(ctx, i, 0);
+    }
+    return;
+  }
+
+  /* Deal out equal ranges, the remainder going to the first workers */
+  const size_t share = count / pool->nthreads;
+  const size_t extra = count % pool->nthreads;
+  size_t begin = 0;
+  int w;
+
+  pthread_mutex_lock(&pool->lock);
+  for (w = 0; w < pool->nthreads; ++w)
+  {
+    struct bn_worker* worker = &pool->workers[w];
+    pthread_mutex_lock(&worker->lock);
+    worker->next = begin;
+    begin += share + ((size_t)w < extra);
+    worker->end = begin;
+    pthread_mutex_unlock(&worker->lock);
+  }
+  pool->fn = fn;
+  pool->ctx = ctx;
+  pool->active = pool->nthreads;
+  pool->generation += 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  _run_batch(&pool->workers[0]);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->active != 0)
+  {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+
+/* Batch operations. */
+struct _many_args
+{
+  const struct bn* a;
+  const struct bn* b;
+  const struct bn* n;
+  struct bn* c;
+  struct bn* d;
+};
+
+static void _pow_mod_job(void* ctx, size_t i, int worker)
+{
+  struct _many_args* args = ctx;
+  bignum_pow_mod(&args->a[i], &args->b[i], &args->n[i], &args->c[i]);
+}
+
+static void _mul_job(void* ctx, size_t i, int worker)
+{
+  struct _many_args* args = ctx;
+  bignum_mul(&args->a[i], &args->b[i], &args->c[i]);
+}
+
+static void _divmod_job(void* ctx, size_t i, int worker)
+{
+  struct _many_args* args = ctx;
+  bignum_divmod(&args->a[i], &args->b[i], &args->c[i], &args->d[i]);
+}
+
+struct _prime_args
+{
+  const struct bn* n;
+  int* res;
+};
+
+static void _prime_job(void* ctx, size_t i, int worker)
+{
+  struct _prime_args* args = ctx;
+  args->res[i] = bignum_is_probable_prime(&args->n[i]);
+}
+
+
+void bignum_pow_mod_many(struct bn_pool* pool, const struct bn* a, const struct bn* b, const struct bn* n, struct bn* res, size_t count)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(n, "n is null");
+  require(res, "res is null");
+
+  struct _many_args args = { a, b, n, res, NULL };
+  bn_pool_run(pool, count, _pow_mod_job, &args);
+}
+
+
+void bignum_mul_many(struct bn_pool* pool, const struct bn* a, const struct bn* b, struct bn* c, size_t count)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  struct _many_args args = { a, b, NULL, c, NULL };
+  bn_pool_run(pool, count, _mul_job, &args);
+}
+
+
+void bignum_divmod_many(struct bn_pool* pool, const struct bn* a, const struct bn* b, struct bn* c, struct bn* d, size_t count)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+  require(d, "d is null");
+
+  struct _many_args args = { a, b, NULL, c, d };
+  bn_pool_run(pool, count, _divmod_job, &args);
+}
+
+
+void bignum_is_probable_prime_many(struct bn_pool* pool, const struct bn* n, int* res, size_t count)
+{
+  require(n, "n is null");
+  require(res, "res is null");
+
+  struct _prime_args args = { n, res };
+  bn_pool_run(pool, count, _prime_job, &args);
+}
+
+
+/* Parallel multiplication: each job multiplies a block of rows of a by b and adds the partial product to the sum. */
+struct _mul_args
+{
+  const struct bn* a;
+  const struct bn* b;
+  struct bn sum;
+  pthread_mutex_t lock;
+  int nrows;
+  int rows_per_job;
+};
+
+static void _mul_rows_job(void* ctx, size_t k, int worker)
+{
+  struct _mul_args* args = ctx;
+  struct bn rows;
+  struct bn partial;
+  int lo = (int)k * args->rows_per_job;
+  int hi = lo + args->rows_per_job;
+  int i;
+
+  hi = (hi < args->nrows) ? hi : args->nrows;
+
+  /* bignum_mul() skips zero limbs, so only rows lo .. hi-1 cost anything */
+  bignum_init(&rows);
+  for (i = lo; i < hi; ++i)
+  {
+    rows.array[i] = args->a->array[i];
+  }
+  bignum_mul(&rows, args->b, &partial);
+
+  /* Addition is exact and commutative: the order the blocks arrive in does not matter */
+  pthread_mutex_lock(&args->lock);
+  bignum_add(&args->sum, &partial, &args->sum);
+  pthread_mutex_unlock(&args->lock);
+}
+
+
+void bignum_mul_parallel(struct bn_pool* pool, const struct bn* a, const struct bn* b, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  const int nrows = _nlimbs(a);
+  const long work = (long)nrows * _nlimbs(b);
+  if ((pool == NULL) || (pool->nthreads == 1) || (work < (long)pool->mul_threshold * pool->mul_threshold))
+  {
+    bignum_mul(a, b, c);
+    return;
+  }
+
+  /* A few blocks per thread, so that work stealing can even out the shorter rows near the top */
+  struct _mul_args args;
+  int njobs = 4 * pool->nthreads;
+  njobs = (njobs < nrows) ? njobs : nrows;
+
+  args.a = a;
+  args.b = b;
+  args.nrows = nrows;
+  args.rows_per_job = (nrows + njobs - 1) / njobs;
+  bignum_init(&args.sum);
+  pthread_mutex_init(&args.lock, NULL);
+
+  bn_pool_run(pool, (nrows + args.rows_per_job - 1) / args.rows_per_job, _mul_rows_job, &args);
+
+  pthread_mutex_destroy(&args.lock);
+  bignum_assign(c, &args.sum);
+}
+
+
+/* Parallel product tree: one subtree per thread, then the subtree products are combined pairwise, one level at a time. */
+struct _product_args
+{
+  struct bn* parts;
+  uint32_t lo;
+  uint32_t count;
+  int nparts;
+  int step;
+};
+
+static void _subtree_job(void* ctx, size_t k, int worker)
+{
+  struct _product_args* args = ctx;
+  uint32_t lo = args->lo + (uint32_t)((uint64_t)args->count * k / args->nparts);
+  uint32_t end = args->lo + (uint32_t)((uint64_t)args->count * (k + 1) / args->nparts);
+  bignum_product_range(lo, end - 1, &args->parts[k]);
+}
+
+static void _combine_job(void* ctx, size_t k, int worker)
+{
+  struct _product_args* args = ctx;
+  size_t i = k * 2 * args->step;
+  bignum_mul(&args->parts[i], &args->parts[i + args->step], &args->parts[i]);
+}
+
+
+void bignum_product_range_parallel(struct bn_pool* pool, uint32_t lo, uint32_t hi, struct bn* out)
+{
+  require(out, "out is null");
+
+  const uint32_t min_factors = BN_PRODUCT_PARALLEL_THRESHOLD;
+  if ((pool == NULL) || (pool->nthreads == 1) || (lo == 0) || (lo > hi) || (hi - lo < 2 * min_factors))
+  {
+    bignum_product_range(lo, hi, out);
+    return;
+  }
+
+  struct _product_args args;
+  args.lo = lo;
+  args.count = hi - lo + 1;
+  args.nparts = pool->nthreads;
+  if (args.count / min_factors < (uint32_t)args.nparts)
+  {
+    args.nparts = (int)(args.count / min_factors);
+  }
+
+  /* One subtree product per thread at most: bn_pool_init() caps nthreads at BN_POOL_MAX_THREADS */
+  struct bn parts[BN_POOL_MAX_THREADS];
+  args.parts = parts;
+  bn_pool_run(pool, args.nparts, _subtree_job, &args);
+
+  for (args.step = 1; args.step < args.nparts; args.step *= 2)
+  {
+    bn_pool_run(pool, (args.nparts - args.step + 2 * args.step - 1) / (2 * args.step), _combine_job, &args);
+  }
+
+  bignum_assign(out, &parts[0]);
+}
+
+
+void bignum_factorial_parallel(struct bn_pool* pool, uint32_t n, struct bn* out)
+{
+  require(out, "out is null");
+
+  bignum_product_range_parallel(pool, 2, n, out);
+}
+
+
+/* Private / Static functions. */
+static void* _worker_main(void* arg)
+{
+  struct bn_worker* self = arg;
+  struct bn_pool* pool = self->pool;
+  unsigned long seen = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  while (1)
+  {
+    while (!pool->shutdown && (pool->generation == seen))
+    {
+      pthread_cond_wait(&pool->start, &pool->lock);
+    }
+    if (pool->shutdown)
+    {
+      break;
+    }
+    seen = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    _run_batch(self);
+
+    pthread_mutex_lock(&pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+
+/* Run jobs until no worker has any left, then leave the batch */
+static void _run_batch(struct bn_worker* self)
+{
+  struct bn_pool* pool = self->pool;
+  size_t index;
+
+  do
+  {
+    while (_take_job(self, &index))
+    {
+      pool->fn(pool->ctx, index, self->id);
+    }
+  }
+  while (_steal_jobs(self));
+
+  pthread_mutex_lock(&pool->lock);
+  pool->active -= 1;
+  if (pool->active == 0)
+  {
+    pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+
+/* Pop the next job from the front of our own range */
+static int _take_job(struct bn_worker* self, size_t* index)
+{
+  int found = 0;
+
+  pthread_mutex_lock(&self->lock);
+  if (self->next < self->end)
+  {
+    *index = self->next;
+    self->next += 1;
+    found = 1;
+  }
+  pthread_mutex_unlock(&self->lock);
+
+  return found;
+}
+
+
+/* Move the back half of another worker's range into our own, 0 if all ranges are empty */
+static int _steal_jobs(struct bn_worker* self)
+{
+  struct bn_pool* pool = self->pool;
+  int i;
+
+  for (i = 1; i < pool->nthreads; ++i)
+  {
+    struct bn_worker* victim = &pool->workers[(self->id + i) % pool->nthreads];
+    size_t begin = 0, end = 0;
+
+    pthread_mutex_lock(&victim->lock);
+    if (victim->next < victim->end)
+    {
+      end = victim->end;
+      begin = victim->next + (victim->end - victim->next) / 2;
+      victim->end = begin;
+    }
+    pthread_mutex_unlock(&victim->lock);
+
+    if (begin < end)
+    {
+      pthread_mutex_lock(&self->lock);
+      self->next = begin;
+      self->end = end;
+      pthread_mutex_unlock(&self->lock);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+/* Number of significant limbs in a, at least one */
+static int _nlimbs(const struct bn* a)
+{
+  int i = BN_ARRAY_SIZE;
+  while ((i > 1) && (a->array[i - 1] == 0))
+  {
+    i -= 1;
+  }
+  return i;
+}
@@ -0,0 +1,121 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+#ifndef __BIGNUM_THREAD_H__
+#define __BIGNUM_THREAD_H__
+/*
+
+Thread pool for bignum operations.
+
+The bignum functions keep all their state on the stack, so independent
+operations can run on as many cores as are available. A pool owns a fixed
+set of worker threads; a batch of jobs is split evenly between the workers
+and a worker that runs out of jobs steals half of the remaining range of
+another worker. The thread calling bn_pool_run() takes part as worker 0 and
+the call returns once every job of the batch has completed.
+
+All memory lives in struct bn_pool: no dynamic allocation.
+A pool runs one batch at a time, bn_pool_run() must not be called
+concurrently on the same pool.
+
+*/
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "bignum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Upper bound for the number of threads in a pool (including the caller) */
+#ifndef BN_POOL_MAX_THREADS
+  #define BN_POOL_MAX_THREADS 64
+#endif
+
+/* Operands with fewer limbs than this are multiplied on the calling thread alone */
+#ifndef BN_MUL_PARALLEL_THRESHOLD
+  #define BN_MUL_PARALLEL_THRESHOLD 128
+#endif
+
+/* Minimum number of factors per thread in bignum_product_range_parallel() */
+#ifndef BN_PRODUCT_PARALLEL_THRESHOLD
+  #define BN_PRODUCT_PARALLEL_THRESHOLD 256
+#endif
+
+/* A job: process element 'index' of a batch, 'worker' is 0 .. nthreads-1 */
+typedef void (*bn_task_fn)(void* ctx, size_t index, int worker);
+
+struct bn_pool;
+
+/* Per-thread state: the range [next, end) of jobs still to be taken */
+struct bn_worker {
+  struct bn_pool* pool;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  size_t next;
+  size_t end;
+  int id;
+};
+
+struct bn_pool {
+  int nthreads;
+  int mul_threshold;        /* limbs, see bignum_mul_parallel(); BN_MUL_PARALLEL_THRESHOLD by default */
+  struct bn_worker workers[BN_POOL_MAX_THREADS];
+  pthread_mutex_t lock;
+  pthread_cond_t start;     /* a new batch was posted */
+  pthread_cond_t done;      /* the last worker left the batch */
+  unsigned long generation; /* batch counter */
+  int active;               /* workers still inside the current batch */
+  int shutdown;
+  bn_task_fn fn;
+  void* ctx;
+};
+
+/* Pool management: */
+int  bn_pool_init(struct bn_pool* pool, int nthreads);  /* nthreads <= 0: one per online CPU. Returns 0 on success */
+void bn_pool_destroy(struct bn_pool* pool);
+void bn_pool_run(struct bn_pool* pool, size_t count, bn_task_fn fn, void* ctx); /* fn(ctx, i, worker) for i in 0 .. count-1 */
+
+/* Batch operations: element i of every array forms one job. A NULL pool runs the batch on the calling thread. */
+void bignum_pow_mod_many(struct bn_pool* pool, const struct bn* a, const struct bn* b, const struct bn* n, struct bn* res, size_t count);
+void bignum_mul_many(struct bn_pool* pool, const struct bn* a, const struct bn* b, struct bn* c, size_t count);
+void bignum_divmod_many(struct bn_pool* pool, const struct bn* a, const struct bn* b, struct bn* c, struct bn* d, size_t count);
+void bignum_is_probable_prime_many(struct bn_pool* pool, const struct bn* n, int* res, size_t count); /* res[i] = bignum_is_probable_prime(n[i]) */
+
+/* c = a * b for very large operands: blocks of rows of the schoolbook product run as separate jobs.
+   The result is identical to bignum_mul() whatever the number of threads. */
+void bignum_mul_parallel(struct bn_pool* pool, const struct bn* a, const struct bn* b, struct bn* c);
+
+/* bignum_product_range() / bignum_factorial() with the independent subtrees evaluated by different threads */
+void bignum_product_range_parallel(struct bn_pool* pool, uint32_t lo, uint32_t hi, struct bn* out);
+void bignum_factorial_parallel(struct bn_pool* pool, uint32_t n, struct bn* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef __BIGNUM_THREAD_H__ */
@@ -43,19 +43,202 @@ There may well be room for performance-optimizations and improvements.
 
 */
 
-#include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 #include <assert.h>
 
 #include "bignum.h"
 
 
+/* Largest power of ten that fits a limb, the unit of decimal conversion */
+#if (WORD_SIZE == 1)
+  #define DEC_CHUNK_DIGITS 2
+  #define DEC_CHUNK_BASE   100
+#elif (WORD_SIZE == 2)
+  #define DEC_CHUNK_DIGITS 4
+  #define DEC_CHUNK_BASE   10000
+#else
+  #define DEC_CHUNK_DIGITS 9
+  #define DEC_CHUNK_BASE   1000000000
+#endif
+
+/* Limbs are stored least significant first, so on little-endian hosts the array is the little-endian byte string */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  #define BN_HOST_LITTLE_ENDIAN 1
+#else
+  #define BN_HOST_LITTLE_ENDIAN 0
+#endif
+
+/* Lowercase hex digits, singly and as the two-digit spelling of every byte */
+#define _HEX_ROW(h) h"0" h"1" h"2" h"3" h"4" h"5" h"6" h"7" h"8" h"9" h"a" h"b" h"c" h"d" h"e" h"f"
+static const char _hex_digits[] = "0123456789abcdef";
+static const char _hex_pairs[] =
+  _HEX_ROW("0") _HEX_ROW("1") _HEX_ROW("2") _HEX_ROW("3") _HEX_ROW("4") _HEX_ROW("5") _HEX_ROW("6") _HEX_ROW("7")
+  _HEX_ROW("8") _HEX_ROW("9") _HEX_ROW("a") _HEX_ROW("b") _HEX_ROW("c") _HEX_ROW("d") _HEX_ROW("e") _HEX_ROW("f");
+
+/* One more than the value of every hex digit, either case, zero for all other characters */
+static const uint8_t _hex_values[256] =
+{
+  ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,  ['5'] = 6,  ['6'] = 7,  ['7'] = 8,
+  ['8'] = 9,  ['9'] = 10, ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+  ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+/* Digits of bignum_to_radix(), and the Bitcoin base58 and RFC 4648 base64 alphabets */
+static const char _radix_digits[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ+/";
+static const char _base58_digits[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+static const char _base64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* One more than the value of every digit in these alphabets, zero for all other characters */
+static const uint8_t _radix_values[256] =
+{
+  ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,  ['5'] = 6,  ['6'] = 7,  ['7'] = 8,
+  ['8'] = 9,  ['9'] = 10, ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+  ['g'] = 17, ['h'] = 18, ['i'] = 19, ['j'] = 20, ['k'] = 21, ['l'] = 22, ['m'] = 23, ['n'] = 24,
+  ['o'] = 25, ['p'] = 26, ['q'] = 27, ['r'] = 28, ['s'] = 29, ['t'] = 30, ['u'] = 31, ['v'] = 32,
+  ['w'] = 33, ['x'] = 34, ['y'] = 35, ['z'] = 36, ['A'] = 37, ['B'] = 38, ['C'] = 39, ['D'] = 40,
+  ['E'] = 41, ['F'] = 42, ['G'] = 43, ['H'] = 44, ['I'] = 45, ['J'] = 46, ['K'] = 47, ['L'] = 48,
+  ['M'] = 49, ['N'] = 50, ['O'] = 51, ['P'] = 52, ['Q'] = 53, ['R'] = 54, ['S'] = 55, ['T'] = 56,
+  ['U'] = 57, ['V'] = 58, ['W'] = 59, ['X'] = 60, ['Y'] = 61, ['Z'] = 62, ['+'] = 63, ['/'] = 64,
+};
+
+static const uint8_t _base58_values[256] =
+{
+  ['1'] = 1,  ['2'] = 2,  ['3'] = 3,  ['4'] = 4,  ['5'] = 5,  ['6'] = 6,  ['7'] = 7,  ['8'] = 8,
+  ['9'] = 9,  ['A'] = 10, ['B'] = 11, ['C'] = 12, ['D'] = 13, ['E'] = 14, ['F'] = 15, ['G'] = 16,
+  ['H'] = 17, ['J'] = 18, ['K'] = 19, ['L'] = 20, ['M'] = 21, ['N'] = 22, ['P'] = 23, ['Q'] = 24,
+  ['R'] = 25, ['S'] = 26, ['T'] = 27, ['U'] = 28, ['V'] = 29, ['W'] = 30, ['X'] = 31, ['Y'] = 32,
+  ['Z'] = 33, ['a'] = 34, ['b'] = 35, ['c'] = 36, ['d'] = 37, ['e'] = 38, ['f'] = 39, ['g'] = 40,
+  ['h'] = 41, ['i'] = 42, ['j'] = 43, ['k'] = 44, ['m'] = 45, ['n'] = 46, ['o'] = 47, ['p'] = 48,
+  ['q'] = 49, ['r'] = 50, ['s'] = 51, ['t'] = 52, ['u'] = 53, ['v'] = 54, ['w'] = 55, ['x'] = 56,
+  ['y'] = 57, ['z'] = 58,
+};
+
+static const uint8_t _base64_values[256] =
+{
+  ['A'] = 1,  ['B'] = 2,  ['C'] = 3,  ['D'] = 4,  ['E'] = 5,  ['F'] = 6,  ['G'] = 7,  ['H'] = 8,
+  ['I'] = 9,  ['J'] = 10, ['K'] = 11, ['L'] = 12, ['M'] = 13, ['N'] = 14, ['O'] = 15, ['P'] = 16,
+  ['Q'] = 17, ['R'] = 18, ['S'] = 19, ['T'] = 20, ['U'] = 21, ['V'] = 22, ['W'] = 23, ['X'] = 24,
+  ['Y'] = 25, ['Z'] = 26, ['a'] = 27, ['b'] = 28, ['c'] = 29, ['d'] = 30, ['e'] = 31, ['f'] = 32,
+  ['g'] = 33, ['h'] = 34, ['i'] = 35, ['j'] = 36, ['k'] = 37, ['l'] = 38, ['m'] = 39, ['n'] = 40,
+  ['o'] = 41, ['p'] = 42, ['q'] = 43, ['r'] = 44, ['s'] = 45, ['t'] = 46, ['u'] = 47, ['v'] = 48,
+  ['w'] = 49, ['x'] = 50, ['y'] = 51, ['z'] = 52, ['0'] = 53, ['1'] = 54, ['2'] = 55, ['3'] = 56,
+  ['4'] = 57, ['5'] = 58, ['6'] = 59, ['7'] = 60, ['8'] = 61, ['9'] = 62, ['+'] = 63, ['/'] = 64,
+};
+
+
 /* Functions for shifting number in-place. */
-static void _lshift_one_bit(struct bn* a);
 static void _rshift_one_bit(struct bn* a);
 static void _lshift_word(struct bn* a, int nwords);
 static void _rshift_word(struct bn* a, int nwords);
 
+/* Single-limb arithmetic, in-place. */
+static DTYPE _mul_add_word(struct bn* a, DTYPE m, DTYPE add);
+static DTYPE _divmod_word(struct bn* a, DTYPE d);
+
+/* Number of significant limbs / bits. */
+static int  _nlimbs(const struct bn* a);
+static int  _nbits(const struct bn* a);
+
+/* Decimal output, see bignum_to_decimal() and bignum_write_decimal(). */
+struct _text_sink
+{
+  char* str;
+  int   maxsize;
+  int   len;
+  bn_write_fn write;  /* if set, str is a buffer of maxsize characters, passed on whenever it fills up */
+  void* ctx;
+  int   fill;
+  int   status;
+};
+static void _sink_flush(struct _text_sink* out);
+static void _sink_put(struct _text_sink* out, const char* text, int len);
+static void _sink_zeros(struct _text_sink* out, int count);
+static void _decimal_leaf(const struct bn* x, int pad, struct _text_sink* out);
+static void _decimal_split(const struct bn* x, int k, int pad, const struct bn* pows, int leaf_digits, struct _text_sink* out);
+static void _write_decimal(const struct bn* n, struct _text_sink* out);
+static int  _decimal_leaf_digits(void);
+static int  _decimal_levels(size_t ndigits);
+static int  _decimal_powers(struct bn* pows, int nlevels);
+
+/* Decimal input, see bignum_from_decimal(). */
+static DTYPE _decimal_chunk(const char* str, int len);
+static void _decimal_parse_chunks(const char* str, size_t len, struct bn* out);
+static void _decimal_parse(const char* str, size_t len, const struct bn* pows, int k, int leaf_digits, struct bn* out);
+
+/* Byte order conversion of single limbs, see bignum_from_bytes_be() etc. */
+static DTYPE _load_be(const uint8_t* p, int len);
+static void _store_be(uint8_t* p, DTYPE limb, int len);
+#if !BN_HOST_LITTLE_ENDIAN
+static DTYPE _load_le(const uint8_t* p, int len);
+static void _store_le(uint8_t* p, DTYPE limb, int len);
+#endif
+
+/* Conversion to and from other bases, see bignum_to_radix(). */
+static DTYPE _radix_chunk(int base, int* ndigits);
+static int  _to_radix(const struct bn* n, char* str, int maxsize, int base, const char* digits);
+static int  _to_radix_pow2(const struct bn* n, char* str, int maxsize, int bits);
+static int  _from_radix(struct bn* n, const char* str, size_t len, int base, const uint8_t* values, int fold);
+static int  _radix_digit(char c, const uint8_t* values, int fold);
+
+/* Balanced product tree behind bignum_product_range(). */
+static void _product_range(uint32_t lo, uint32_t hi, struct bn* out);
+static void _mul_factor(struct bn* out, DTYPE_TMP* acc, uint32_t factor);
+
+/* Prime factorization of factorials and binomials, see bignum_factorial_swing(). */
+static void _sieve(uint32_t n, uint8_t* composite);
+static int  _is_odd_prime(uint32_t p, const uint8_t* composite);
+static uint32_t _binomial_exponent(uint32_t p, uint32_t n, uint32_t k, uint32_t m);
+static void _prime_product(uint32_t lo, uint32_t hi, uint32_t n, uint32_t k, uint32_t m, const uint8_t* composite, struct bn* out);
+static void _factorial_swing(uint32_t n, const uint8_t* composite, struct bn* out);
+
+/* Modular addition and subtraction on the low n limbs, see bignum_mod_add(). */
+static void _mod_add(struct bn* c, const struct bn* a, const struct bn* b, const struct bn* m, int n);
+static void _mod_sub(struct bn* c, const struct bn* a, const struct bn* b, const struct bn* m, int n);
+static void _clear_above(struct bn* a, int n);
+
+/* Montgomery arithmetic helpers, see bignum_pow_mod_x4() / bignum_pow_mod_x8(). */
+static DTYPE _mont_minv(DTYPE m0);
+static void _mont_consts(const struct bn* m, int nlimbs, struct bn* one, struct bn* r2);
+
+/* Montgomery arithmetic in one struct bn_mont, see bignum_pow_mod(), bignum_is_probable_prime() and bignum_mont_init(). */
+static void _mont_init(struct bn_mont* ctx, const struct bn* m, int lazy);
+static void _mont_mul(struct bn* r, const struct bn* a, const struct bn* b, const struct bn_mont* ctx);
+static void _mont_sqr(struct bn* r, const struct bn* a, const struct bn_mont* ctx);
+static void _mont_redc(struct bn* r, const DTYPE* t, DTYPE hi, const struct bn_mont* ctx, int reduce);
+static void _mont_pow(struct bn* r, const struct bn* a, const struct bn* e, const struct bn_mont* ctx);
+
+/* Cache of Montgomery contexts by modulus, see bignum_pow_mod() and bignum_modcache_stats(). */
+static int  _modcache_get(const struct bn* m, struct bn_mont* ctx);
+static void _modcache_put(const struct bn_mont* ctx);
+#if (BN_MODCACHE_SIZE > 0)
+static unsigned long _modcache_hash(const struct bn* m);
+#endif
+
+/* Binary GCD and inverse helpers on the low n limbs, see bignum_gcd() and bignum_modinv(). */
+static int  _ctz(const struct bn* a);
+static void _shr_limbs(struct bn* a, int nbits, int n);
+static DTYPE _sub_limbs(struct bn* a, const struct bn* b, int n);
+static int  _cmp_limbs(const struct bn* a, const struct bn* b, int n);
+static int  _is_zero_limbs(const struct bn* a, int n);
+static void _mod_halve(struct bn* x, int k, const struct bn* m, DTYPE minv, int n);
+static int  _modinv_odd(const struct bn* a, const struct bn* m, struct bn* inv);
+static void _inv_pow2(const struct bn* a, int s, struct bn* inv);
+static void _truncate_bits(struct bn* a, int nbits);
+static void _gcd_lehmer(struct bn* u, struct bn* v);
+static int  _lehmer_matrix(uint64_t x, uint64_t y, int64_t* m);
+static void _lehmer_row(struct bn* out, const struct bn* u, const struct bn* v, int64_t a, int64_t b, int n);
+static DTYPE _bits_at(const struct bn* a, int shift);
+
+/* Primality testing helpers, see bignum_is_probable_prime(). */
+static DTYPE_TMP _mod_small(const struct bn* a, DTYPE_TMP d);
+static int  _bpsw(const struct bn* n);
+static void _sieve_window(struct bn_sieve* s);
+static int  _miller_rabin(const struct bn_mont* ctx, const struct bn* d, int s, DTYPE base);
+static int  _strong_lucas(const struct bn_mont* ctx);
+static void _lucas_const(struct bn* x, int32_t c, const struct bn_mont* ctx);
+static int  _is_square(const struct bn* n);
+
 
 /* Public / Exported functions. */
 void bignum_init(struct bn* n)
@@ -119,604 +302,4096 @@ int bignum_to_int(struct bn* n)
 }
 
 
-void bignum_from_string(struct bn* n, const char* str, int nbytes)
+int bignum_from_string(struct bn* n, const char* str, int nbytes)
 {
   require(n, "n is null");
   require(str, "str is null");
-  require(nbytes > 0, "nbytes must be positive");
-  require((nbytes & 1) == 0, "string format must be in hex -> equal number of bytes");
-  require((nbytes % (sizeof(DTYPE) * 2)) == 0, "string length must be a multiple of (sizeof(DTYPE) * 2) characters");
-  
+  require(nbytes >= 0, "nbytes must not be negative");
+
+  int i, j, k;
+
   bignum_init(n);
 
-  DTYPE tmp;                        /* DTYPE is defined in bn.h - uint{8,16,32,64}_t */
-  int i = nbytes - (2 * WORD_SIZE); /* index into string */
-  int j = 0;                        /* index into array */
+  /* Optional 0x prefix */
+  if ((nbytes >= 2) && (str[0] == '0') && ((str[1] == 'x') || (str[1] == 'X')))
+  {
+    str += 2;
+    nbytes -= 2;
+  }
+  if (nbytes == 0)
+  {
+    return BN_INVALID;
+  }
+
+  /* A zero table entry marks a character that is not a hex digit */
+  int invalid = 0;
+  for (i = 0; i < nbytes; ++i)
+  {
+    invalid |= (_hex_values[(uint8_t)str[i]] == 0);
+  }
+  if (invalid)
+  {
+    return BN_INVALID;
+  }
+
+  /* Skip leading zeros, so the length says how large the value is */
+  while ((nbytes > 1) && (str[0] == '0'))
+  {
+    str += 1;
+    nbytes -= 1;
+  }
+  if (nbytes > (2 * WORD_SIZE * BN_ARRAY_SIZE))
+  {
+    return BN_OVERFLOW;
+  }
 
-  /* reading last hex-byte "MSB" from string first -> big endian */
-  /* MSB ~= most significant byte / block ? :) */
-  while (i >= 0)
+  /* reading last hex-digits "LSB" from string first, one limb's worth at a time */
+  i = nbytes; /* index into string, one past the limb being read */
+  j = 0;      /* index into array */
+  while (i > 0)
   {
-    tmp = 0;
-    sscanf(&str[i], SSCANF_FORMAT_STR, &tmp);
-    n->array[j] = tmp;
-    i -= (2 * WORD_SIZE); /* step WORD_SIZE hex-byte(s) back in the string. */
-    j += 1;               /* step one element forward in the array. */
+    const int start = (i > (2 * WORD_SIZE)) ? (i - (2 * WORD_SIZE)) : 0;
+    DTYPE_TMP limb = 0;
+    for (k = start; k < i; ++k)
+    {
+      limb = (limb << 4) | (DTYPE_TMP)(_hex_values[(uint8_t)str[k]] - 1);
+    }
+    n->array[j] = (DTYPE)limb;
+    i = start;
+    j += 1;
   }
+
+  return BN_OK;
 }
 
 
-void bignum_to_string(const struct bn* n, char* str, int nbytes)
+int bignum_to_string(const struct bn* n, char* str, int maxsize)
 {
   require(n, "n is null");
-  require(str, "str is null");
-  require(nbytes > 0, "nbytes must be positive");
-  require((nbytes & 1) == 0, "string format must be in hex -> equal number of bytes");
-
-  int j = BN_ARRAY_SIZE - 1; /* index into array - reading "MSB" first -> big-endian */
-  int i = 0;                 /* index into string representation. */
+  require((str || (maxsize == 0)), "str is null");
+  require(maxsize >= 0, "maxsize must not be negative");
+
+  /* Start at the top significant limb, and its top nonzero hex digit */
+  const int top = _nlimbs(n) - 1;
+  const DTYPE msl = n->array[top];
+  int ndigits = 2 * WORD_SIZE;
+  while ((ndigits > 1) && ((msl >> (4 * (ndigits - 1))) == 0))
+  {
+    ndigits -= 1;
+  }
+  const int len = ndigits + (2 * WORD_SIZE * top);
 
-  /* reading last array-element "MSB" first -> big endian */
-  while ((j >= 0) && (nbytes > (i + 1)))
+  if (maxsize == 0)
   {
-    sprintf(&str[i], SPRINTF_FORMAT_STR, n->array[j]);
-    i += (2 * WORD_SIZE); /* step WORD_SIZE hex-byte(s) forward in the string. */
-    j -= 1;               /* step one element back in the array. */
+    return len;
   }
 
-  /* Count leading zeros: */
-  j = 0;
-  while (str[j] == '0')
+  int i = 0; /* index into string representation. */
+  int j;
+  int k;
+
+  if (len < maxsize)
   {
-    j += 1;
+    /* Everything fits: digit by digit for the top limb, then two digits per byte */
+    for (k = ndigits - 1; k >= 0; --k)
+    {
+      str[i++] = _hex_digits[(msl >> (4 * k)) & 0xf];
+    }
+    for (j = top - 1; j >= 0; --j)
+    {
+      for (k = WORD_SIZE - 1; k >= 0; --k)
+      {
+        const int byte = (n->array[j] >> (8 * k)) & 0xff;
+        str[i++] = _hex_pairs[2 * byte];
+        str[i++] = _hex_pairs[2 * byte + 1];
+      }
+    }
   }
- 
-  /* Move string j places ahead, effectively skipping leading zeros */ 
-  for (i = 0; i < (nbytes - j); ++i)
+  else
   {
-    str[i] = str[i + j];
+    /* Truncated like snprintf(): as many of the leading digits as fit */
+    for (j = top; (j >= 0) && (i < maxsize - 1); --j)
+    {
+      for (k = ((j == top) ? ndigits : (2 * WORD_SIZE)) - 1; (k >= 0) && (i < maxsize - 1); --k)
+      {
+        str[i++] = _hex_digits[(n->array[j] >> (4 * k)) & 0xf];
+      }
+    }
   }
 
   /* Zero-terminate string */
   str[i] = 0;
+
+  return len;
 }
 
 
-void bignum_dec(struct bn* n)
+int bignum_to_decimal(const struct bn* n, char* str, int maxsize)
 {
   require(n, "n is null");
+  require((str || (maxsize == 0)), "str is null");
+  require(maxsize >= 0, "maxsize must not be negative");
 
-  DTYPE tmp; /* copy of n */
-  DTYPE res;
+  struct _text_sink out;
+  out.str = str;
+  out.maxsize = maxsize;
+  out.len = 0;
+  out.write = NULL;
 
-  int i;
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
-  {
-    tmp = n->array[i];
-    res = tmp - 1;
-    n->array[i] = res;
+  _write_decimal(n, &out);
 
-    if (!(res > tmp))
-    {
-      break;
-    }
+  /* Zero-terminate string, truncated like snprintf() */
+  if (maxsize > 0)
+  {
+    str[(out.len < maxsize) ? out.len : (maxsize - 1)] = 0;
   }
+
+  return out.len;
 }
 
 
-void bignum_inc(struct bn* n)
+int bignum_write_decimal(const struct bn* n, bn_write_fn write, void* ctx)
 {
   require(n, "n is null");
+  require(write, "write is null");
+
+  char buf[BN_WRITE_BUFSIZE];
+  struct _text_sink out;
+  out.str = buf;
+  out.maxsize = sizeof(buf);
+  out.len = 0;
+  out.write = write;
+  out.ctx = ctx;
+  out.fill = 0;
+  out.status = BN_OK;
+
+  /* Digits leave in order, most significant first, as soon as the buffer fills */
+  _write_decimal(n, &out);
+  _sink_flush(&out);
+
+  return (out.status == BN_OK) ? out.len : out.status;
+}
 
-  DTYPE res;
-  DTYPE_TMP tmp; /* copy of n */
 
-  int i;
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
-  {
-    tmp = n->array[i];
-    res = tmp + 1;
-    n->array[i] = res;
+int bignum_from_decimal(struct bn* n, const char* str, size_t len)
+{
+  require(n, "n is null");
+  require(str, "str is null");
 
-    if (res > tmp)
+  size_t i;
+
+  bignum_init(n);
+
+  if (len == 0)
+  {
+    return BN_INVALID;
+  }
+  for (i = 0; i < len; ++i)
+  {
+    if ((str[i] < '0') || (str[i] > '9'))
     {
-      break;
+      return BN_INVALID;
     }
   }
-}
 
+  /* Skip leading zeros, so the length says how large the value is */
+  while ((len > 1) && (str[0] == '0'))
+  {
+    str += 1;
+    len -= 1;
+  }
 
-void bignum_add(const struct bn* a, const struct bn* b, struct bn* c)
-{
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
+  /* From about the length of the largest value on, compare with its digits */
+  const size_t bound = (((size_t)BN_ARRAY_SIZE * WORD_SIZE * 8 * 1233) >> 12) + 1;
+  if (len >= bound)
+  {
+    char largest[bound + 2];
+    struct bn max;
+    bignum_init(&max);
+    bignum_dec(&max);
+    const size_t maxlen = bignum_to_decimal(&max, largest, sizeof(largest));
+    require(maxlen < sizeof(largest), "log10(2) estimate is off");
+    if ((len > maxlen) || ((len == maxlen) && (memcmp(str, largest, len) > 0)))
+    {
+      return BN_OVERFLOW;
+    }
+  }
 
-  DTYPE_TMP tmp;
-  int carry = 0;
-  int i;
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  const int nlevels = _decimal_levels(len - 1);
+  if (nlevels == 0)
   {
-    tmp = (DTYPE_TMP)a->array[i] + b->array[i] + carry;
-    carry = (tmp > MAX_VAL);
-    c->array[i] = (tmp & MAX_VAL);
+    _decimal_parse_chunks(str, len, n);
+    return BN_OK;
   }
+
+  struct bn pows[nlevels];
+  const int k = _decimal_powers(pows, nlevels);
+  if (k == 0)
+  {
+    _decimal_parse_chunks(str, len, n);
+    return BN_OK;
+  }
+
+  _decimal_parse(str, len, pows, k - 1, _decimal_leaf_digits(), n);
+  return BN_OK;
 }
 
+int bignum_nbytes(const struct bn* n)
+{
+  require(n, "n is null");
 
-void bignum_sub(const struct bn* a, const struct bn* b, struct bn* c)
+  return (_nbits(n) + 7) / 8;
+}
+
+
+int bignum_nbits(const struct bn* n)
 {
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
+  require(n, "n is null");
 
-  DTYPE_TMP res;
-  DTYPE_TMP tmp1;
-  DTYPE_TMP tmp2;
-  int borrow = 0;
-  int i;
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
-  {
-    tmp1 = (DTYPE_TMP)a->array[i] + (MAX_VAL + 1); /* + number_base */
-    tmp2 = (DTYPE_TMP)b->array[i] + borrow;;
-    res = (tmp1 - tmp2);
-    c->array[i] = (DTYPE)(res & MAX_VAL); /* "modulo number_base" == "% (number_base - 1)" if number_base is 2^N */
-    borrow = (res <= MAX_VAL);
-  }
+  return _nbits(n);
 }
 
 
-void bignum_mul(const struct bn* a, const struct bn* b, struct bn* c)
+int bignum_from_bytes_be(struct bn* n, const uint8_t* buf, size_t len)
 {
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
+  require(n, "n is null");
+  require((buf || (len == 0)), "buf is null");
 
-  struct bn row;
-  struct bn tmp;
-  int i, j;
+  size_t i;
 
-  bignum_init(c);
+  bignum_init(n);
 
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  /* Skip leading zero bytes, so the length says how large the value is */
+  while ((len > 0) && (buf[0] == 0))
+  {
+    buf += 1;
+    len -= 1;
+  }
+  if (len > sizeof(n->array))
   {
-    bignum_init(&row);
+    return BN_OVERFLOW;
+  }
 
-    for (j = 0; j < BN_ARRAY_SIZE; ++j)
-    {
-      if (i + j < BN_ARRAY_SIZE)
-      {
-        bignum_init(&tmp);
-        DTYPE_TMP intermediate = ((DTYPE_TMP)a->array[i] * (DTYPE_TMP)b->array[j]);
-        bignum_from_int(&tmp, intermediate);
-        _lshift_word(&tmp, i + j);
-        bignum_add(&tmp, &row, &row);
-      }
-    }
-    bignum_add(c, &row, c);
+  /* Whole limbs from the end of the buffer, then the partial top limb */
+  const size_t nfull = len / WORD_SIZE;
+  for (i = 0; i < nfull; ++i)
+  {
+    n->array[i] = _load_be(&buf[len - (WORD_SIZE * (i + 1))], WORD_SIZE);
+  }
+  if (len % WORD_SIZE)
+  {
+    n->array[nfull] = _load_be(buf, len % WORD_SIZE);
   }
+
+  return BN_OK;
 }
 
 
-void bignum_div(const struct bn* a, const struct bn* b, struct bn* c)
+int bignum_from_bytes_le(struct bn* n, const uint8_t* buf, size_t len)
 {
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
-
-  struct bn current;
-  struct bn denom;
-  struct bn tmp;
+  require(n, "n is null");
+  require((buf || (len == 0)), "buf is null");
 
-  bignum_from_int(&current, 1);               // int current = 1;
-  bignum_assign(&denom, b);                   // denom = b
-  bignum_assign(&tmp, a);                     // tmp   = a
+  bignum_init(n);
 
-  const DTYPE_TMP half_max = 1 + (DTYPE_TMP)(MAX_VAL / 2);
-  bool overflow = false;
-  while (bignum_cmp(&denom, a) != LARGER)     // while (denom <= a) {
+  /* Skip trailing zero bytes, which are the most significant ones */
+  while ((len > 0) && (buf[len - 1] == 0))
   {
-    if (denom.array[BN_ARRAY_SIZE - 1] >= half_max)
-    {
-      overflow = true;
-      break;
-    }
-    _lshift_one_bit(&current);                //   current <<= 1;
-    _lshift_one_bit(&denom);                  //   denom <<= 1;
+    len -= 1;
   }
-  if (!overflow)
+  if (len > sizeof(n->array))
   {
-    _rshift_one_bit(&denom);                  // denom >>= 1;
-    _rshift_one_bit(&current);                // current >>= 1;
+    return BN_OVERFLOW;
   }
-  bignum_init(c);                             // int answer = 0;
 
-  while (!bignum_is_zero(&current))           // while (current != 0)
+#if BN_HOST_LITTLE_ENDIAN
+  memcpy(n->array, buf, len);
+#else
+  size_t i;
+  for (i = 0; i < len; i += WORD_SIZE)
   {
-    if (bignum_cmp(&tmp, &denom) != SMALLER)  //   if (dividend >= denom)
-    {
-      bignum_sub(&tmp, &denom, &tmp);         //     dividend -= denom;
-      bignum_or(c, &current, c);              //     answer |= current;
-    }
-    _rshift_one_bit(&current);                //   current >>= 1;
-    _rshift_one_bit(&denom);                  //   denom >>= 1;
-  }                                           // return answer;
+    n->array[i / WORD_SIZE] = _load_le(&buf[i], ((len - i) < WORD_SIZE) ? (int)(len - i) : WORD_SIZE);
+  }
+#endif
+
+  return BN_OK;
 }
 
 
-void bignum_lshift(const struct bn* a, struct bn* b, int nbits)
+int bignum_to_bytes_be(const struct bn* n, uint8_t* buf, size_t len)
 {
-  require(a, "a is null");
-  require(b, "b is null");
-  require(nbits >= 0, "no negative shifts");
+  require(n, "n is null");
+  require((buf || (len == 0)), "buf is null");
 
-  bignum_assign(b, a);
-  /* Handle shift in multiples of word-size */
-  const int nbits_pr_word = (WORD_SIZE * 8);
-  int nwords = nbits / nbits_pr_word;
-  if (nwords != 0)
+  const size_t nbytes = bignum_nbytes(n);
+  size_t i;
+
+  if (nbytes > len)
   {
-    _lshift_word(b, nwords);
-    nbits -= (nwords * nbits_pr_word);
+    return BN_OVERFLOW;
   }
 
-  if (nbits != 0)
+  /* Zero padding up front, then whole limbs from the end of the buffer and the partial top limb */
+  memset(buf, 0, len - nbytes);
+  const size_t nfull = nbytes / WORD_SIZE;
+  for (i = 0; i < nfull; ++i)
   {
-    int i;
-    for (i = (BN_ARRAY_SIZE - 1); i > 0; --i)
-    {
-      b->array[i] = (b->array[i] << nbits) | (b->array[i - 1] >> ((8 * WORD_SIZE) - nbits));
-    }
-    b->array[i] <<= nbits;
+    _store_be(&buf[len - (WORD_SIZE * (i + 1))], n->array[i], WORD_SIZE);
   }
+  if (nbytes % WORD_SIZE)
+  {
+    _store_be(&buf[len - nbytes], n->array[nfull], nbytes % WORD_SIZE);
+  }
+
+  return BN_OK;
 }
 
 
-void bignum_rshift(const struct bn* a, struct bn* b, int nbits)
+int bignum_to_bytes_le(const struct bn* n, uint8_t* buf, size_t len)
 {
-  require(a, "a is null");
-  require(b, "b is null");
-  require(nbits >= 0, "no negative shifts");
-  
-  bignum_assign(b, a);
-  /* Handle shift in multiples of word-size */
-  const int nbits_pr_word = (WORD_SIZE * 8);
-  int nwords = nbits / nbits_pr_word;
-  if (nwords != 0)
+  require(n, "n is null");
+  require((buf || (len == 0)), "buf is null");
+
+  const size_t nbytes = bignum_nbytes(n);
+
+  if (nbytes > len)
   {
-    _rshift_word(b, nwords);
-    nbits -= (nwords * nbits_pr_word);
+    return BN_OVERFLOW;
   }
 
-  if (nbits != 0)
+#if BN_HOST_LITTLE_ENDIAN
+  memcpy(buf, n->array, nbytes);
+#else
+  size_t i;
+  for (i = 0; i < nbytes; i += WORD_SIZE)
   {
-    int i;
-    for (i = 0; i < (BN_ARRAY_SIZE - 1); ++i)
+    _store_le(&buf[i], n->array[i / WORD_SIZE], ((nbytes - i) < WORD_SIZE) ? (int)(nbytes - i) : WORD_SIZE);
+  }
+#endif
+  memset(&buf[nbytes], 0, len - nbytes);
+
+  return BN_OK;
+}
+
+int bignum_to_radix(const struct bn* n, char* str, int maxsize, int base)
+{
+  require(n, "n is null");
+  require((str || (maxsize == 0)), "str is null");
+  require(maxsize >= 0, "maxsize must not be negative");
+  require((base >= 2) && (base <= 64), "base must be 2 to 64");
+
+  /* Powers of two are bit fields, everything else takes divisions */
+  if ((base & (base - 1)) == 0)
+  {
+    int bits = 0;
+    while ((1 << bits) < base)
     {
-      b->array[i] = (b->array[i] >> nbits) | (b->array[i + 1] << ((8 * WORD_SIZE) - nbits));
+      bits += 1;
     }
-    b->array[i] >>= nbits;
+    return _to_radix_pow2(n, str, maxsize, bits);
   }
-  
+  return _to_radix(n, str, maxsize, base, _radix_digits);
 }
 
 
-void bignum_mod(const struct bn* a, const struct bn* b, struct bn* c)
+int bignum_from_radix(struct bn* n, const char* str, size_t len, int base)
 {
-  /*
-    Take divmod and throw away div part
-  */
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
-
-  struct bn tmp;
+  require(n, "n is null");
+  require(str, "str is null");
+  require((base >= 2) && (base <= 64), "base must be 2 to 64");
 
-  bignum_divmod(a,b,&tmp,c);
+  return _from_radix(n, str, len, base, _radix_values, (base <= 36));
 }
 
-void bignum_divmod(const struct bn* a, const struct bn* b, struct bn* c, struct bn* d)
+
+int bignum_to_base58(const struct bn* n, char* str, int maxsize)
 {
-  /*
-    Puts a%b in d
-    and a/b in c
+  require(n, "n is null");
+  require((str || (maxsize == 0)), "str is null");
+  require(maxsize >= 0, "maxsize must not be negative");
 
-    mod(a,b) = a - ((a / b) * b)
+  return _to_radix(n, str, maxsize, 58, _base58_digits);
+}
 
-    example:
-      mod(8, 3) = 8 - ((8 / 3) * 3) = 2
-  */
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
+
+int bignum_from_base58(struct bn* n, const char* str, size_t len)
+{
+  require(n, "n is null");
+  require(str, "str is null");
+
+  return _from_radix(n, str, len, 58, _base58_values, 0);
+}
+
+
+int bignum_to_base64(const struct bn* n, char* str, int maxsize)
+{
+  require(n, "n is null");
+  require((str || (maxsize == 0)), "str is null");
+  require(maxsize >= 0, "maxsize must not be negative");
+
+  /* The big-endian bytes, at least one, three to every four characters */
+  uint8_t bytes[sizeof(n->array)];
+  const int nbytes = (bignum_nbytes(n) > 0) ? bignum_nbytes(n) : 1;
+  const int len = 4 * ((nbytes + 2) / 3);
+  int i, j = 0;
+
+  if (maxsize == 0)
+  {
+    return len;
+  }
+
+  bignum_to_bytes_be(n, bytes, nbytes);
+  for (i = 0; (i < nbytes) && (j < maxsize - 1); i += 3)
+  {
+    const uint32_t group = ((uint32_t)bytes[i] << 16)
+                         | (((i + 1) < nbytes) ? ((uint32_t)bytes[i + 1] << 8) : 0)
+                         | (((i + 2) < nbytes) ? (uint32_t)bytes[i + 2] : 0);
+    char quad[4];
+    quad[0] = _base64_digits[(group >> 18) & 0x3f];
+    quad[1] = _base64_digits[(group >> 12) & 0x3f];
+    quad[2] = ((i + 1) < nbytes) ? _base64_digits[(group >> 6) & 0x3f] : '=';
+    quad[3] = ((i + 2) < nbytes) ? _base64_digits[group & 0x3f] : '=';
+    int k;
+    for (k = 0; (k < 4) && (j < maxsize - 1); ++k)
+    {
+      str[j++] = quad[k];
+    }
+  }
+  str[j] = 0;
+
+  return len;
+}
+
+
+int bignum_from_base64(struct bn* n, const char* str, size_t len)
+{
+  require(n, "n is null");
+  require(str, "str is null");
+
+  uint8_t bytes[sizeof(n->array)];
+  size_t nbytes = 0;
+  size_t i;
+  uint32_t group = 0;
+  int ngroup = 0;
+  int overflow = 0;
+
+  bignum_init(n);
+
+  /* Up to two '=' of padding, which may also be left out */
+  if ((len > 0) && (str[len - 1] == '='))
+  {
+    len -= 1;
+    if ((len > 0) && (str[len - 1] == '='))
+    {
+      len -= 1;
+    }
+  }
+  if ((len == 0) || ((len % 4) == 1))
+  {
+    return BN_INVALID;
+  }
+
+  for (i = 0; i < len; ++i)
+  {
+    const int value = _base64_values[(uint8_t)str[i]];
+    if (value == 0)
+    {
+      return BN_INVALID;
+    }
+    group = (group << 6) | (uint32_t)(value - 1);
+    ngroup += 1;
+
+    /* Every four characters, or the two or three at the end, make one byte less than their number */
+    if ((ngroup == 4) || (i == len - 1))
+    {
+      const int nout = ngroup - 1;
+      int k;
+      group <<= 6 * (4 - ngroup);
+      for (k = 0; k < nout; ++k)
+      {
+        const uint8_t byte = (uint8_t)(group >> (16 - 8 * k));
+        /* Leading zero bytes do not count towards the size */
+        if ((nbytes == 0) && (byte == 0))
+        {
+          continue;
+        }
+        if (nbytes == sizeof(bytes))
+        {
+          overflow = 1;
+          continue;
+        }
+        bytes[nbytes++] = byte;
+      }
+      group = 0;
+      ngroup = 0;
+    }
+  }
+
+  if (overflow)
+  {
+    return BN_OVERFLOW;
+  }
+  return bignum_from_bytes_be(n, bytes, nbytes);
+}
+
+
+
+void bignum_dec(struct bn* n)
+{
+  require(n, "n is null");
+
+  DTYPE tmp; /* copy of n */
+  DTYPE res;
+
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    tmp = n->array[i];
+    res = tmp - 1;
+    n->array[i] = res;
+
+    if (!(res > tmp))
+    {
+      break;
+    }
+  }
+}
+
+
+void bignum_inc(struct bn* n)
+{
+  require(n, "n is null");
+
+  DTYPE res;
+  DTYPE_TMP tmp; /* copy of n */
+
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    tmp = n->array[i];
+    res = tmp + 1;
+    n->array[i] = res;
+
+    if (res > tmp)
+    {
+      break;
+    }
+  }
+}
+
+
+void bignum_add(const struct bn* a, const struct bn* b, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  DTYPE_TMP tmp;
+  int carry = 0;
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    tmp = (DTYPE_TMP)a->array[i] + b->array[i] + carry;
+    carry = (tmp > MAX_VAL);
+    c->array[i] = (tmp & MAX_VAL);
+  }
+}
+
+
+void bignum_sub(const struct bn* a, const struct bn* b, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  DTYPE_TMP res;
+  DTYPE_TMP tmp1;
+  DTYPE_TMP tmp2;
+  int borrow = 0;
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    tmp1 = (DTYPE_TMP)a->array[i] + (MAX_VAL + 1); /* + number_base */
+    tmp2 = (DTYPE_TMP)b->array[i] + borrow;;
+    res = (tmp1 - tmp2);
+    c->array[i] = (DTYPE)(res & MAX_VAL); /* "modulo number_base" == "% (number_base - 1)" if number_base is 2^N */
+    borrow = (res <= MAX_VAL);
+  }
+}
+
+
+void bignum_mul(const struct bn* a, const struct bn* b, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  struct bn res;
+  DTYPE_TMP tmp;
+  DTYPE carry;
+  int i, j;
+
+  bignum_init(&res);
+
+  /* Schoolbook multiplication, one row per limb of a, truncated to BN_ARRAY_SIZE limbs */
+  const int nb = _nlimbs(b);
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    if (a->array[i] == 0)
+    {
+      continue;
+    }
+
+    const int ncols = ((i + nb) < BN_ARRAY_SIZE) ? nb : (BN_ARRAY_SIZE - i);
+    carry = 0;
+    for (j = 0; j < ncols; ++j)
+    {
+      tmp = (DTYPE_TMP)a->array[i] * b->array[j] + res.array[i + j] + carry;
+      res.array[i + j] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> (8 * WORD_SIZE));
+    }
+    if (i + ncols < BN_ARRAY_SIZE)
+    {
+      res.array[i + ncols] = carry;
+    }
+  }
+
+  bignum_assign(c, &res);
+}
+
+
+void bignum_div(const struct bn* a, const struct bn* b, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  struct bn tmp;
+
+  bignum_divmod(a, b, c, &tmp);
+}
+
+
+void bignum_lshift(const struct bn* a, struct bn* b, int nbits)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(nbits >= 0, "no negative shifts");
+
+  bignum_assign(b, a);
+  /* Handle shift in multiples of word-size */
+  const int nbits_pr_word = (WORD_SIZE * 8);
+  int nwords = nbits / nbits_pr_word;
+  if (nwords != 0)
+  {
+    _lshift_word(b, nwords);
+    nbits -= (nwords * nbits_pr_word);
+  }
+
+  if (nbits != 0)
+  {
+    int i;
+    for (i = (BN_ARRAY_SIZE - 1); i > 0; --i)
+    {
+      b->array[i] = (b->array[i] << nbits) | (b->array[i - 1] >> ((8 * WORD_SIZE) - nbits));
+    }
+    b->array[i] <<= nbits;
+  }
+}
+
+
+void bignum_rshift(const struct bn* a, struct bn* b, int nbits)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(nbits >= 0, "no negative shifts");
+  
+  bignum_assign(b, a);
+  /* Handle shift in multiples of word-size */
+  const int nbits_pr_word = (WORD_SIZE * 8);
+  int nwords = nbits / nbits_pr_word;
+  if (nwords != 0)
+  {
+    _rshift_word(b, nwords);
+    nbits -= (nwords * nbits_pr_word);
+  }
+
+  if (nbits != 0)
+  {
+    int i;
+    for (i = 0; i < (BN_ARRAY_SIZE - 1); ++i)
+    {
+      b->array[i] = (b->array[i] >> nbits) | (b->array[i + 1] << ((8 * WORD_SIZE) - nbits));
+    }
+    b->array[i] >>= nbits;
+  }
+  
+}
+
+
+void bignum_mod(const struct bn* a, const struct bn* b, struct bn* c)
+{
+  /*
+    Take divmod and throw away div part
+  */
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
 
   struct bn tmp;
 
-  /* c = (a / b) */
-  bignum_div(a, b, c);
+  bignum_divmod(a,b,&tmp,c);
+}
+
+void bignum_divmod(const struct bn* a, const struct bn* b, struct bn* c, struct bn* d)
+{
+  /*
+    Puts a%b in d
+    and a/b in c
+
+    Long division one limb at a time (Knuth, TAOCP vol. 2, 4.3.1, algorithm D):
+    every quotient limb is estimated from the top limbs of the remainder and of
+    the normalized divisor, and that estimate is at most two too large.
+  */
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+  require(d, "d is null");
+  require(!bignum_is_zero(b), "division by zero");
+
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  const int n = _nlimbs(b);
+  const int m = _nlimbs(a);
+  DTYPE u[BN_ARRAY_SIZE + 1]; /* normalized dividend, ends up as the normalized remainder */
+  DTYPE v[BN_ARRAY_SIZE];     /* normalized divisor */
+  struct bn q;
+  struct bn r;
+  DTYPE_TMP qhat, rhat, prod, tmp, carry;
+  DTYPE borrow;
+  int i, j, s;
+
+  if (bignum_cmp(a, b) == SMALLER)
+  {
+    bignum_assign(d, a);
+    bignum_init(c);
+    return;
+  }
+
+  bignum_init(&q);
+  bignum_init(&r);
+
+  if (n == 1)
+  {
+    bignum_assign(&q, a);
+    r.array[0] = _divmod_word(&q, b->array[0]);
+    bignum_assign(c, &q);
+    bignum_assign(d, &r);
+    return;
+  }
+
+  /* Shift both operands left until the top bit of the divisor is set */
+  s = 0;
+  while ((((DTYPE_TMP)b->array[n - 1] << s) & DTYPE_MSB) == 0)
+  {
+    s += 1;
+  }
+  for (i = n - 1; i > 0; --i)
+  {
+    v[i] = (DTYPE)(((DTYPE_TMP)b->array[i] << s) | ((DTYPE_TMP)b->array[i - 1] >> (nbits_pr_word - s)));
+  }
+  v[0] = (DTYPE)((DTYPE_TMP)b->array[0] << s);
+  u[m] = (DTYPE)((DTYPE_TMP)a->array[m - 1] >> (nbits_pr_word - s));
+  for (i = m - 1; i > 0; --i)
+  {
+    u[i] = (DTYPE)(((DTYPE_TMP)a->array[i] << s) | ((DTYPE_TMP)a->array[i - 1] >> (nbits_pr_word - s)));
+  }
+  u[0] = (DTYPE)((DTYPE_TMP)a->array[0] << s);
+
+  for (j = m - n; j >= 0; --j)
+  {
+    /* Estimate the quotient limb from the top two limbs, refine it with the third */
+    tmp = ((DTYPE_TMP)u[j + n] << nbits_pr_word) | u[j + n - 1];
+    qhat = tmp / v[n - 1];
+    rhat = tmp % v[n - 1];
+    while ((qhat > MAX_VAL) || ((qhat * v[n - 2]) > ((rhat << nbits_pr_word) | u[j + n - 2])))
+    {
+      qhat -= 1;
+      rhat += v[n - 1];
+      if (rhat > MAX_VAL)
+      {
+        break;
+      }
+    }
+
+    /* u[j .. j+n] -= qhat * v */
+    carry = 0;
+    borrow = 0;
+    for (i = 0; i < n; ++i)
+    {
+      prod = (qhat * v[i]) + carry;
+      carry = (prod >> nbits_pr_word);
+      tmp = (DTYPE_TMP)u[i + j] - (DTYPE)prod - borrow;
+      u[i + j] = (DTYPE)tmp;
+      borrow = (tmp > MAX_VAL);
+    }
+    tmp = (DTYPE_TMP)u[j + n] - carry - borrow;
+    u[j + n] = (DTYPE)tmp;
+
+    /* Rarely the estimate was still one too large: add the divisor back */
+    if (tmp > MAX_VAL)
+    {
+      qhat -= 1;
+      carry = 0;
+      for (i = 0; i < n; ++i)
+      {
+        tmp = (DTYPE_TMP)u[i + j] + v[i] + carry;
+        u[i + j] = (DTYPE)tmp;
+        carry = (tmp >> nbits_pr_word);
+      }
+      u[j + n] = (DTYPE)(u[j + n] + carry);
+    }
+
+    q.array[j] = (DTYPE)qhat;
+  }
+
+  /* Undo the normalization on the remainder */
+  for (i = 0; i < n; ++i)
+  {
+    r.array[i] = (DTYPE)(((DTYPE_TMP)u[i] >> s) | ((DTYPE_TMP)u[i + 1] << (nbits_pr_word - s)));
+  }
+
+  bignum_assign(c, &q);
+  bignum_assign(d, &r);
+}
+
+
+void bignum_and(const struct bn* a, const struct bn* b, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    c->array[i] = (a->array[i] & b->array[i]);
+  }
+}
+
+
+void bignum_or(const struct bn* a, const struct bn* b, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    c->array[i] = (a->array[i] | b->array[i]);
+  }
+}
+
+
+void bignum_xor(const struct bn* a, const struct bn* b, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    c->array[i] = (a->array[i] ^ b->array[i]);
+  }
+}
+
+
+int bignum_cmp(const struct bn* a, const struct bn* b)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+
+  int i = BN_ARRAY_SIZE;
+  do
+  {
+    i -= 1; /* Decrement first, to start with last array element */
+    if (a->array[i] > b->array[i])
+    {
+      return LARGER;
+    }
+    else if (a->array[i] < b->array[i])
+    {
+      return SMALLER;
+    }
+  }
+  while (i != 0);
+
+  return EQUAL;
+}
+
+
+int bignum_is_zero(const struct bn* n)
+{
+  require(n, "n is null");
+
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    if (n->array[i])
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+void bignum_pow(const struct bn* a, const struct bn* b, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(c, "c is null");
+
+  struct bn tmp;
+
+  bignum_init(c);
+
+  if (bignum_cmp(b, c) == EQUAL)
+  {
+    /* Return 1 when exponent is 0 -- n^0 = 1 */
+    bignum_inc(c);
+  }
+  else
+  {
+    struct bn bcopy;
+    bignum_assign(&bcopy, b);
+
+    /* Copy a -> tmp */
+    bignum_assign(&tmp, a);
+
+    bignum_dec(&bcopy);
+ 
+    /* Begin summing products: */
+    while (!bignum_is_zero(&bcopy))
+    {
+
+      /* c = tmp * tmp */
+      bignum_mul(&tmp, a, c);
+      /* Decrement b by one */
+      bignum_dec(&bcopy);
+
+      bignum_assign(&tmp, c);
+    }
+
+    /* c = tmp */
+    bignum_assign(c, &tmp);
+  }
+}
+
+void bignum_isqrt(const struct bn *a, struct bn* b)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+
+  struct bn low, high, mid, tmp;
+
+  bignum_init(&low);
+  bignum_assign(&high, a);
+  bignum_rshift(&high, &mid, 1);
+  bignum_inc(&mid);
+
+  while (bignum_cmp(&high, &low) > 0) 
+  {
+    bignum_mul(&mid, &mid, &tmp);
+    if (bignum_cmp(&tmp, a) > 0) 
+    {
+      bignum_assign(&high, &mid);
+      bignum_dec(&high);
+    }
+    else 
+    {
+      bignum_assign(&low, &mid);
+    }
+    bignum_sub(&high,&low,&mid);
+    _rshift_one_bit(&mid);
+    bignum_add(&low,&mid,&mid);
+    bignum_inc(&mid);
+  }
+  bignum_assign(b,&low);
+}
+
+
+void bignum_product_range(uint32_t lo, uint32_t hi, struct bn* out)
+{
+  require(out, "out is null");
+
+  if (lo > hi)
+  {
+    bignum_from_int(out, 1);
+    return;
+  }
+  if (lo == 0)
+  {
+    bignum_init(out);
+    return;
+  }
+  _product_range(lo, hi, out);
+}
+
+
+void bignum_factorial(uint32_t n, struct bn* out)
+{
+  require(out, "out is null");
+
+  bignum_product_range(2, n, out);
+}
+
+
+void bignum_factorial_swing(uint32_t n, struct bn* out)
+{
+  require(out, "out is null");
+
+  if (n > BN_SIEVE_LIMIT)
+  {
+    /* Wraps around anyway, the product tree gives the same truncated value */
+    bignum_factorial(n, out);
+    return;
+  }
+
+  uint8_t composite[BN_SIEVE_LIMIT / 16 + 1];
+  _sieve(n, composite);
+  _factorial_swing(n, composite, out);
+
+  /* The factors of two were left out of every swing number: n! has n - popcount(n) of them */
+  uint32_t twos = n;
+  uint32_t bits = n;
+  while (bits)
+  {
+    twos -= (bits & 1);
+    bits >>= 1;
+  }
+  bignum_lshift(out, out, (int)twos);
+}
+
+
+void bignum_binomial(uint32_t n, uint32_t k, struct bn* out)
+{
+  require(out, "out is null");
+
+  if (k > n)
+  {
+    bignum_init(out);
+    return;
+  }
+
+  if (n <= BN_SIEVE_LIMIT)
+  {
+    /* Product of the prime powers dividing n! / (k! (n-k)!) */
+    uint8_t composite[BN_SIEVE_LIMIT / 16 + 1];
+    _sieve(n, composite);
+    _prime_product(3, n, n, k, n - k, composite, out);
+    bignum_lshift(out, out, (int)_binomial_exponent(2, n, k, n - k));
+    return;
+  }
+
+  /*
+    C(n, i) = C(n, i-1) * (n - k + i) / i, on limbs wide enough for the product by a 32-bit factor
+    so that every division is exact. C(n, i) grows with i up to n / 2: when C(n, k) fits, every
+    quotient on the way fits as well.
+  */
+  DTYPE c[BN_ARRAY_SIZE + 4 / WORD_SIZE];
+  int used = 1;
+  uint32_t i;
+  int j;
+
+  k = (k < n - k) ? k : (n - k);
+  c[0] = 1;
+  for (i = 1; i <= k; ++i)
+  {
+    const uint64_t factor = n - k + i;
+    uint64_t tmp = 0;
+    for (j = 0; j < used; ++j)
+    {
+      tmp += c[j] * factor;
+      c[j] = (DTYPE)tmp;
+      tmp >>= (8 * WORD_SIZE);
+    }
+    while (tmp)
+    {
+      c[used++] = (DTYPE)tmp;
+      tmp >>= (8 * WORD_SIZE);
+    }
+    for (j = used - 1; j >= 0; --j)
+    {
+      tmp = (tmp << (8 * WORD_SIZE)) | c[j];
+      c[j] = (DTYPE)(tmp / i);
+      tmp %= i;
+    }
+    while ((used > 1) && (c[used - 1] == 0))
+    {
+      used -= 1;
+    }
+    if (used > BN_ARRAY_SIZE)
+    {
+      require(0, "C(n, k) does not fit");
+      used = BN_ARRAY_SIZE;
+      break;
+    }
+  }
+
+  bignum_init(out);
+  for (j = 0; j < used; ++j)
+  {
+    out->array[j] = c[j];
+  }
+}
+
+
+void bignum_assign(struct bn* dst, const struct bn* src)
+{
+  require(dst, "dst is null");
+  require(src, "src is null");
+
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    dst->array[i] = src->array[i];
+  }
+}
+
+
+/* Private / Static functions. */
+static DTYPE _divmod_word(struct bn* a, DTYPE d)
+{
+  /* a = a / d, returns the remainder */
+  DTYPE_TMP rem = 0;
+  int i;
+  for (i = BN_ARRAY_SIZE - 1; i >= 0; --i)
+  {
+    rem = (rem << (8 * WORD_SIZE)) | a->array[i];
+    a->array[i] = (DTYPE)(rem / d);
+    rem %= d;
+  }
+  return (DTYPE)rem;
+}
+
+
+static DTYPE _mul_add_word(struct bn* a, DTYPE m, DTYPE add)
+{
+  /* a = a * m + add, returns the limb that did not fit */
+  DTYPE_TMP tmp;
+  DTYPE carry = add;
+  int i;
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    tmp = (DTYPE_TMP)a->array[i] * m + carry;
+    a->array[i] = (DTYPE)tmp;
+    carry = (DTYPE)(tmp >> (8 * WORD_SIZE));
+  }
+  return carry;
+}
+
+
+/* Hand the buffered characters to the writer, remembering its first error */
+static void _sink_flush(struct _text_sink* out)
+{
+  if ((out->fill > 0) && (out->status == BN_OK))
+  {
+    const int status = out->write(out->ctx, out->str, out->fill);
+    if (status < 0)
+    {
+      out->status = status;
+    }
+  }
+  out->fill = 0;
+}
+
+
+/* Append len characters to the sink, counting the ones that do not fit */
+static void _sink_put(struct _text_sink* out, const char* text, int len)
+{
+  int i;
+  if (out->write)
+  {
+    for (i = 0; i < len; ++i)
+    {
+      if (out->fill == out->maxsize)
+      {
+        _sink_flush(out);
+      }
+      out->str[out->fill++] = text[i];
+    }
+    out->len += len;
+    return;
+  }
+  for (i = 0; i < len; ++i)
+  {
+    if (out->len + i < out->maxsize - 1)
+    {
+      out->str[out->len + i] = text[i];
+    }
+  }
+  out->len += len;
+}
+
+
+static void _sink_zeros(struct _text_sink* out, int count)
+{
+  const char zeros[] = "0000000000000000";
+  while (count > 0)
+  {
+    const int len = (count < 16) ? count : 16;
+    _sink_put(out, zeros, len);
+    count -= len;
+  }
+}
+
+
+/* Digits of x < 10^(DEC_CHUNK_DIGITS * BN_DECIMAL_LEAF_CHUNKS), zero-filled to at least pad digits */
+static void _decimal_leaf(const struct bn* x, int pad, struct _text_sink* out)
+{
+  char digits[DEC_CHUNK_DIGITS * (BN_DECIMAL_LEAF_CHUNKS + 2)]; /* two spare chunks for arrays too narrow to split */
+  DTYPE limbs[BN_ARRAY_SIZE];
+  DTYPE_TMP rem;
+  DTYPE chunk;
+  int n = _nlimbs(x);
+  int i = sizeof(digits);
+  int j;
+
+  for (j = 0; j < n; ++j)
+  {
+    limbs[j] = x->array[j];
+  }
+
+  /* Peel off DEC_CHUNK_DIGITS digits per single-limb division, least significant first */
+  while ((n > 1) || (limbs[0] != 0))
+  {
+    rem = 0;
+    for (j = n - 1; j >= 0; --j)
+    {
+      rem = (rem << (8 * WORD_SIZE)) | limbs[j];
+      limbs[j] = (DTYPE)(rem / DEC_CHUNK_BASE);
+      rem %= DEC_CHUNK_BASE;
+    }
+    if ((n > 1) && (limbs[n - 1] == 0))
+    {
+      n -= 1;
+    }
+
+    chunk = (DTYPE)rem;
+    for (j = 0; j < DEC_CHUNK_DIGITS; ++j)
+    {
+      digits[--i] = (char)('0' + (chunk % 10));
+      chunk /= 10;
+    }
+  }
+
+  /* Skip the leading zeros of the top chunk */
+  while ((i < (int)sizeof(digits)) && (digits[i] == '0'))
+  {
+    i += 1;
+  }
+
+  _sink_zeros(out, pad - ((int)sizeof(digits) - i));
+  _sink_put(out, &digits[i], (int)sizeof(digits) - i);
+}
+
+
+/*
+  Digits of x, zero-filled to at least pad digits, where pows[k] = 10^(leaf_digits * 2^k).
+  x is split into x / pows[k] and x % pows[k], so that each half is converted with numbers
+  half the size, down to pows[0] where the leaves take over.
+*/
+static void _decimal_split(const struct bn* x, int k, int pad, const struct bn* pows, int leaf_digits, struct _text_sink* out)
+{
+  struct bn hi;
+  struct bn lo;
+
+  /* Nothing more to do once the writer failed */
+  if (out->write && (out->status != BN_OK))
+  {
+    return;
+  }
+
+  while ((k >= 0) && (bignum_cmp(x, &pows[k]) == SMALLER))
+  {
+    k -= 1;
+  }
+  if (k < 0)
+  {
+    _decimal_leaf(x, pad, out);
+    return;
+  }
+
+  const int lo_digits = (leaf_digits << k);
+  bignum_divmod(x, &pows[k], &hi, &lo);
+  _decimal_split(&hi, k, (pad > lo_digits) ? (pad - lo_digits) : 0, pows, leaf_digits, out);
+  _decimal_split(&lo, k - 1, lo_digits, pows, leaf_digits, out);
+}
+
+
+/* Digits per leaf: DEC_CHUNK_DIGITS times BN_DECIMAL_LEAF_CHUNKS rounded up to a power of two */
+static int _decimal_leaf_digits(void)
+{
+  int leaf_digits = DEC_CHUNK_DIGITS;
+  int i;
+  for (i = 1; i < BN_DECIMAL_LEAF_CHUNKS; i *= 2)
+  {
+    leaf_digits *= 2;
+  }
+  return leaf_digits;
+}
+
+
+/* Number of levels k with 10^(leaf_digits * 2^k) of at most ndigits digits */
+static int _decimal_levels(size_t ndigits)
+{
+  const size_t leaf_digits = _decimal_leaf_digits();
+  int nlevels = 0;
+  while ((leaf_digits << nlevels) <= ndigits)
+  {
+    nlevels += 1;
+  }
+  return nlevels;
+}
+
+
+/*
+  pows[k] = 10^(leaf_digits * 2^k) for k < nlevels, by repeated squaring.
+  Returns how many fit in a struct bn, zero if the array is too narrow to be worth splitting at all.
+*/
+static int _decimal_powers(struct bn* pows, int nlevels)
+{
+  int i, k;
+
+  bignum_from_int(&pows[0], DEC_CHUNK_BASE);
+  for (i = 1; i < BN_DECIMAL_LEAF_CHUNKS; i *= 2)
+  {
+    if (2 * _nlimbs(&pows[0]) > BN_ARRAY_SIZE)
+    {
+      return 0;
+    }
+    bignum_mul(&pows[0], &pows[0], &pows[0]);
+  }
+  for (k = 1; k < nlevels; ++k)
+  {
+    if (2 * _nlimbs(&pows[k - 1]) > BN_ARRAY_SIZE)
+    {
+      break;
+    }
+    bignum_mul(&pows[k - 1], &pows[k - 1], &pows[k]);
+  }
+  return k;
+}
+
+
+static void _write_decimal(const struct bn* n, struct _text_sink* out)
+{
+  if (bignum_is_zero(n))
+  {
+    _sink_put(out, "0", 1);
+    return;
+  }
+
+  /* Upper bound on the number of digits, with log10(2) ~= 1233 / 4096 */
+  const int nlevels = _decimal_levels(((_nbits(n) * 1233) >> 12) + 1);
+  if (nlevels == 0)
+  {
+    _decimal_leaf(n, 0, out);
+    return;
+  }
+
+  struct bn pows[nlevels];
+  const int k = _decimal_powers(pows, nlevels);
+  if (k == 0)
+  {
+    _decimal_leaf(n, 0, out);
+    return;
+  }
+
+  _decimal_split(n, k - 1, 0, pows, _decimal_leaf_digits(), out);
+}
+
+
+/* Value of the len <= DEC_CHUNK_DIGITS digits at str */
+static DTYPE _decimal_chunk(const char* str, int len)
+{
+  DTYPE val = 0;
+  int i;
+  for (i = 0; i < len; ++i)
+  {
+    val = (DTYPE)(val * 10 + (str[i] - '0'));
+  }
+  return val;
+}
+
+
+/* out = the value of len digits at str, which must fit: one multiply-add per DEC_CHUNK_DIGITS digits */
+static void _decimal_parse_chunks(const char* str, size_t len, struct bn* out)
+{
+  DTYPE_TMP tmp;
+  DTYPE carry;
+  DTYPE scale;
+  int nlimbs = 1;
+  int i, j;
+
+  bignum_init(out);
+
+  /* The first chunk takes the digits left over, so the rest are whole */
+  int first = (int)(len % DEC_CHUNK_DIGITS);
+  if (first == 0)
+  {
+    first = DEC_CHUNK_DIGITS;
+  }
+  size_t pos = 0;
+  int clen = first;
+
+  while (pos < len)
+  {
+    scale = 1;
+    for (j = 0; j < clen; ++j)
+    {
+      scale = (DTYPE)(scale * 10);
+    }
+
+    carry = _decimal_chunk(&str[pos], clen);
+    for (i = 0; i < nlimbs; ++i)
+    {
+      tmp = (DTYPE_TMP)out->array[i] * scale + carry;
+      out->array[i] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> (8 * WORD_SIZE));
+    }
+    if ((carry != 0) && (nlimbs < BN_ARRAY_SIZE))
+    {
+      out->array[nlimbs] = carry;
+      nlimbs += 1;
+    }
+
+    pos += clen;
+    clen = DEC_CHUNK_DIGITS;
+  }
+}
+
+
+/* out = the value of len digits at str, split into a high part and the low leaf_digits * 2^k digits */
+static void _decimal_parse(const char* str, size_t len, const struct bn* pows, int k, int leaf_digits, struct bn* out)
+{
+  struct bn lo;
+
+  while ((k >= 0) && (((size_t)leaf_digits << k) >= len))
+  {
+    k -= 1;
+  }
+  if (k < 0)
+  {
+    _decimal_parse_chunks(str, len, out);
+    return;
+  }
+
+  const size_t lo_digits = ((size_t)leaf_digits << k);
+  _decimal_parse(str, len - lo_digits, pows, k, leaf_digits, out);
+  _decimal_parse(&str[len - lo_digits], lo_digits, pows, k - 1, leaf_digits, &lo);
+  bignum_mul(out, &pows[k], out);
+  bignum_add(out, &lo, out);
+}
+
+/* The len <= WORD_SIZE bytes at p as a limb, most significant byte first */
+static DTYPE _load_be(const uint8_t* p, int len)
+{
+  DTYPE_TMP limb = 0;
+  int i;
+  for (i = 0; i < len; ++i)
+  {
+    limb = (limb << 8) | p[i];
+  }
+  return (DTYPE)limb;
+}
+
+
+/* The low len <= WORD_SIZE bytes of limb at p, most significant byte first */
+static void _store_be(uint8_t* p, DTYPE limb, int len)
+{
+  int i;
+  for (i = len - 1; i >= 0; --i)
+  {
+    p[i] = (uint8_t)limb;
+    limb = (DTYPE)((DTYPE_TMP)limb >> 8);
+  }
+}
+
+
+#if !BN_HOST_LITTLE_ENDIAN
+/* As _load_be() and _store_be(), least significant byte first */
+static DTYPE _load_le(const uint8_t* p, int len)
+{
+  DTYPE_TMP limb = 0;
+  int i;
+  for (i = len - 1; i >= 0; --i)
+  {
+    limb = (limb << 8) | p[i];
+  }
+  return (DTYPE)limb;
+}
+
+
+static void _store_le(uint8_t* p, DTYPE limb, int len)
+{
+  int i;
+  for (i = 0; i < len; ++i)
+  {
+    p[i] = (uint8_t)limb;
+    limb = (DTYPE)((DTYPE_TMP)limb >> 8);
+  }
+}
+#endif
+
+/* Largest power of base that fits a limb, and its exponent */
+static DTYPE _radix_chunk(int base, int* ndigits)
+{
+  DTYPE_TMP chunk = base;
+  *ndigits = 1;
+  while (chunk * base <= MAX_VAL)
+  {
+    chunk *= base;
+    *ndigits += 1;
+  }
+  return (DTYPE)chunk;
+}
+
+
+/*
+  Digits of n in a base that is not a power of two: every single-limb division by
+  the largest power of the base that fits a limb yields a chunk of digits, least
+  significant first.  When they do not all fit, a second pass places the leading ones.
+*/
+static int _to_radix(const struct bn* n, char* str, int maxsize, int base, const char* digits)
+{
+  DTYPE limbs[BN_ARRAY_SIZE];
+  DTYPE_TMP rem;
+  int ndigits;
+  const DTYPE chunk = _radix_chunk(base, &ndigits);
+  int len = 0;
+  int pass, count, nlimbs, top, i, j;
+
+  for (pass = 0; pass < 2; ++pass)
+  {
+    nlimbs = _nlimbs(n);
+    for (i = 0; i < nlimbs; ++i)
+    {
+      limbs[i] = n->array[i];
+    }
+
+    count = 0;
+    do
+    {
+      rem = 0;
+      for (i = nlimbs - 1; i >= 0; --i)
+      {
+        rem = (rem << (8 * WORD_SIZE)) | limbs[i];
+        limbs[i] = (DTYPE)(rem / chunk);
+        rem %= chunk;
+      }
+      if ((nlimbs > 1) && (limbs[nlimbs - 1] == 0))
+      {
+        nlimbs -= 1;
+      }
+
+      /* The top chunk stops at its last nonzero digit, and zero is a single digit */
+      top = ((nlimbs == 1) && (limbs[0] == 0));
+      for (j = 0; (j < ndigits) && !(top && (j > 0) && (rem == 0)); ++j)
+      {
+        const int pos = (pass == 0) ? count : (len - 1 - count);
+        if (pos < maxsize - 1)
+        {
+          str[pos] = digits[rem % base];
+        }
+        rem /= base;
+        count += 1;
+      }
+    } while (!top);
+
+    len = count;
+    if (len < maxsize)
+    {
+      /* Everything fit: reverse into place */
+      for (i = 0; i < len / 2; ++i)
+      {
+        const char c = str[i];
+        str[i] = str[len - 1 - i];
+        str[len - 1 - i] = c;
+      }
+      str[len] = 0;
+      return len;
+    }
+    if (maxsize == 0)
+    {
+      return len;
+    }
+  }
+
+  /* Zero-terminate string, truncated like snprintf() */
+  str[maxsize - 1] = 0;
+  return len;
+}
+
+
+/* Digits of n in base 2^bits, read straight off the bits, most significant first */
+static int _to_radix_pow2(const struct bn* n, char* str, int maxsize, int bits)
+{
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  const int nbits = _nbits(n);
+  const int len = (nbits > 0) ? ((nbits + bits - 1) / bits) : 1;
+  int i, j = 0;
+
+  for (i = len - 1; (i >= 0) && (j < maxsize - 1); --i)
+  {
+    const int pos = i * bits;
+    const int limb = pos / nbits_pr_word;
+    const int shift = pos % nbits_pr_word;
+    DTYPE_TMP value = (DTYPE_TMP)n->array[limb] >> shift;
+    if ((shift + bits > nbits_pr_word) && (limb + 1 < BN_ARRAY_SIZE))
+    {
+      value |= (DTYPE_TMP)n->array[limb + 1] << (nbits_pr_word - shift);
+    }
+    str[j++] = _radix_digits[value & ((1u << bits) - 1)];
+  }
+  if (maxsize > 0)
+  {
+    str[j] = 0;
+  }
+
+  return len;
+}
+
+
+/* n = the value of the digits at str, one multiply-add per chunk of digits that fits a limb */
+static int _from_radix(struct bn* n, const char* str, size_t len, int base, const uint8_t* values, int fold)
+{
+  DTYPE_TMP tmp;
+  DTYPE carry;
+  DTYPE scale;
+  int ndigits;
+  int nlimbs = 1;
+  size_t pos;
+  int i, j;
+
+  bignum_init(n);
+
+  if (len == 0)
+  {
+    return BN_INVALID;
+  }
+  for (pos = 0; pos < len; ++pos)
+  {
+    if (_radix_digit(str[pos], values, fold) >= base)
+    {
+      return BN_INVALID;
+    }
+  }
+
+  /* Powers of two: every digit goes straight to its bit position, least significant first */
+  if ((base & (base - 1)) == 0)
+  {
+    const int nbits_pr_word = (8 * WORD_SIZE);
+    int bits = 0;
+    while ((1 << bits) < base)
+    {
+      bits += 1;
+    }
+    while ((len > 1) && (_radix_digit(str[0], values, fold) == 0))
+    {
+      str += 1;
+      len -= 1;
+    }
+
+    size_t bitpos = 0;
+    for (pos = len; pos-- > 0; bitpos += bits)
+    {
+      const DTYPE_TMP value = _radix_digit(str[pos], values, fold);
+      const size_t limb = bitpos / nbits_pr_word;
+      const int shift = bitpos % nbits_pr_word;
+      if (limb >= BN_ARRAY_SIZE)
+      {
+        /* Only the top digit is certain to be nonzero */
+        bignum_init(n);
+        return BN_OVERFLOW;
+      }
+      n->array[limb] |= (DTYPE)(value << shift);
+      if ((shift + bits) > nbits_pr_word)
+      {
+        const DTYPE spill = (DTYPE)(value >> (nbits_pr_word - shift));
+        if (limb + 1 < BN_ARRAY_SIZE)
+        {
+          n->array[limb + 1] |= spill;
+        }
+        else if (spill != 0)
+        {
+          bignum_init(n);
+          return BN_OVERFLOW;
+        }
+      }
+    }
+    return BN_OK;
+  }
+
+  _radix_chunk(base, &ndigits);
+
+  /* The first chunk takes the digits left over, so the rest are whole */
+  int clen = (int)(len % ndigits);
+  if (clen == 0)
+  {
+    clen = ndigits;
+  }
+
+  for (pos = 0; pos < len; pos += clen, clen = ndigits)
+  {
+    scale = 1;
+    carry = 0;
+    for (j = 0; j < clen; ++j)
+    {
+      scale = (DTYPE)(scale * base);
+      carry = (DTYPE)(carry * base + _radix_digit(str[pos + j], values, fold));
+    }
+
+    for (i = 0; i < nlimbs; ++i)
+    {
+      tmp = (DTYPE_TMP)n->array[i] * scale + carry;
+      n->array[i] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> (8 * WORD_SIZE));
+    }
+    if (carry != 0)
+    {
+      if (nlimbs == BN_ARRAY_SIZE)
+      {
+        bignum_init(n);
+        return BN_OVERFLOW;
+      }
+      n->array[nlimbs] = carry;
+      nlimbs += 1;
+    }
+  }
+
+  return BN_OK;
+}
+
+
+/* Value of the digit c, 64 for characters outside the alphabet; with fold set, letters are case-insensitive */
+static int _radix_digit(char c, const uint8_t* values, int fold)
+{
+  if (fold && (c >= 'A') && (c <= 'Z'))
+  {
+    c = (char)(c - 'A' + 'a');
+  }
+  return (values[(uint8_t)c] == 0) ? 64 : (values[(uint8_t)c] - 1);
+}
+
+
+
+static void _mul_factor(struct bn* out, DTYPE_TMP* acc, uint32_t factor)
+{
+  /* Gather factors in the limb-sized accumulator acc, flushing it into out when full */
+  if (factor > MAX_VAL)
+  {
+    struct bn tmp;
+    bignum_from_int(&tmp, factor);
+    bignum_mul(out, &tmp, out);
+  }
+  else if (*acc * factor > MAX_VAL)
+  {
+    _mul_add_word(out, (DTYPE)*acc, 0);
+    *acc = factor;
+  }
+  else
+  {
+    *acc *= factor;
+  }
+}
+
+
+static void _product_range(uint32_t lo, uint32_t hi, struct bn* out)
+{
+  /* Leaves: multiply runs of small factors into one limb before touching the big number */
+  if (hi - lo < 16)
+  {
+    DTYPE_TMP acc = 1;
+    uint32_t k;
+
+    bignum_from_int(out, 1);
+    for (k = lo; k < hi; ++k)
+    {
+      _mul_factor(out, &acc, k);
+    }
+    _mul_factor(out, &acc, hi);
+    _mul_add_word(out, (DTYPE)acc, 0);
+    return;
+  }
+
+  /* Split in two halves of equal length, so both sub-products have about the same size */
+  struct bn right;
+  uint32_t mid = lo + (hi - lo) / 2;
+  _product_range(lo, mid, out);
+  _product_range(mid + 1, hi, &right);
+  bignum_mul(out, &right, out);
+}
+
+
+static void _rshift_word(struct bn* a, int nwords)
+{
+  /* Naive method: */
+  require(a, "a is null");
+  require(nwords >= 0, "no negative shifts");
+
+  int i;
+  if (nwords >= BN_ARRAY_SIZE)
+  {
+    for (i = 0; i < BN_ARRAY_SIZE; ++i)
+    {
+      a->array[i] = 0;
+    }
+    return;
+  }
+
+  for (i = 0; i < BN_ARRAY_SIZE - nwords; ++i)
+  {
+    a->array[i] = a->array[i + nwords];
+  }
+  for (; i < BN_ARRAY_SIZE; ++i)
+  {
+    a->array[i] = 0;
+  }
+}
+
+
+static void _lshift_word(struct bn* a, int nwords)
+{
+  require(a, "a is null");
+  require(nwords >= 0, "no negative shifts");
+
+  int i;
+  /* Shift whole words */
+  for (i = (BN_ARRAY_SIZE - 1); i >= nwords; --i)
+  {
+    a->array[i] = a->array[i - nwords];
+  }
+  /* Zero pad shifted words. */
+  for (; i >= 0; --i)
+  {
+    a->array[i] = 0;
+  }  
+}
+
+
+static void _rshift_one_bit(struct bn* a)
+{
+  require(a, "a is null");
+
+  int i;
+  for (i = 0; i < (BN_ARRAY_SIZE - 1); ++i)
+  {
+    a->array[i] = (a->array[i] >> 1) | (a->array[i + 1] << ((8 * WORD_SIZE) - 1));
+  }
+  a->array[BN_ARRAY_SIZE - 1] >>= 1;
+}
+
+/* O(log n) */
+void bignum_pow_mod(const struct bn* a, const struct bn* b, const struct bn* n, struct bn* res)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(n, "n is null");
+  require(res, "res is null");
+
+  /* Odd moduli take Montgomery multiplication, which needs no division */
+  if ((n->array[0] & 1) && (_nlimbs(n) > 1 || n->array[0] > 1))
+  {
+    struct bn_mont ctx;
+    struct bn x, one;
+
+    if (!_modcache_get(n, &ctx))
+    {
+      _mont_init(&ctx, n, 0);
+      _modcache_put(&ctx);
+    }
+    bignum_mod(a, n, &x);
+    _mont_mul(&x, &x, &ctx.r2, &ctx);
+    _mont_pow(&x, &x, b, &ctx);
+    bignum_from_int(&one, 1);
+    _mont_mul(&x, &x, &one, &ctx);
+    bignum_assign(res, &x);
+    return;
+  }
+
+  bignum_from_int(res, 1); /* r = 1 */
+
+  struct bn tmpa;
+  struct bn tmpb;
+  struct bn tmp;
+  bignum_assign(&tmpa, a);
+  bignum_assign(&tmpb, b);
+
+  while (1)
+  {
+    if (tmpb.array[0] & 1) /* if (b % 2) */
+    {
+      bignum_mul(res, &tmpa, &tmp); /* r = r * a % m */
+      bignum_mod(&tmp, n, res);
+    }
+    bignum_rshift(&tmpb, &tmp, 1); /* b /= 2 */
+    bignum_assign(&tmpb, &tmp);
+
+    if (bignum_is_zero(&tmpb))
+      break;
+
+    bignum_mul(&tmpa, &tmpa, &tmp);
+    bignum_mod(&tmp, n, &tmpa);
+  }
+}
+
+
+/*
+  Exponentiation by a machine-word exponent, for RSA verification with e = 3 or 65537. The
+  bits of e after the top one are walked left to right straight from the word, so e = 65537
+  costs 16 squarings and a single multiplication, with nothing spent on the exponent itself.
+*/
+void bignum_pow_mod_word(const struct bn* a, DTYPE_TMP e, const struct bn* n, struct bn* res)
+{
+  require(a, "a is null");
+  require(n, "n is null");
+  require(res, "res is null");
+
+  if (!(n->array[0] & 1) || ((_nlimbs(n) == 1) && (n->array[0] == 1)) || (e == 0))
+  {
+    struct bn b;
+    bignum_from_int(&b, e);
+    bignum_pow_mod(a, &b, n, res);
+    return;
+  }
+
+  struct bn_mont ctx;
+  struct bn base, acc, one;
+  int i;
+
+  if (!_modcache_get(n, &ctx))
+  {
+    _mont_init(&ctx, n, 0);
+    _modcache_put(&ctx);
+  }
+  if (bignum_cmp(a, n) == SMALLER)
+  {
+    bignum_assign(&base, a);
+  }
+  else
+  {
+    bignum_mod(a, n, &base);
+  }
+  _mont_mul(&base, &base, &ctx.r2, &ctx);
+  bignum_assign(&acc, &base);
+
+  i = (8 * (int)sizeof(e)) - 1;
+  while (!((e >> i) & 1))
+  {
+    i -= 1;
+  }
+  for (i -= 1; i >= 0; --i)
+  {
+    _mont_sqr(&acc, &acc, &ctx);
+    if ((e >> i) & 1)
+    {
+      _mont_mul(&acc, &acc, &base, &ctx);
+    }
+  }
+
+  bignum_from_int(&one, 1);
+  _mont_mul(&acc, &acc, &one, &ctx);
+  bignum_assign(res, &acc);
+}
+
+
+/*
+  Modular addition and subtraction of operands already below m. Each is one carry
+  (or borrow) pass over the limbs of m and a correction by m that is selected with a
+  mask rather than a branch, so the time taken does not depend on the values.
+*/
+void bignum_mod_add(const struct bn* a, const struct bn* b, const struct bn* m, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(m, "m is null");
+  require(c, "c is null");
+
+  const int n = _nlimbs(m);
+  _mod_add(c, a, b, m, n);
+  _clear_above(c, n);
+}
+
+
+void bignum_mod_sub(const struct bn* a, const struct bn* b, const struct bn* m, struct bn* c)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(m, "m is null");
+  require(c, "c is null");
+
+  const int n = _nlimbs(m);
+  _mod_sub(c, a, b, m, n);
+  _clear_above(c, n);
+}
+
+
+void bignum_mod_neg(const struct bn* a, const struct bn* m, struct bn* c)
+{
+  require(a, "a is null");
+  require(m, "m is null");
+  require(c, "c is null");
+
+  const int n = _nlimbs(m);
+  struct bn zero;
+  bignum_init(&zero);
+  _mod_sub(c, &zero, a, m, n);
+  _clear_above(c, n);
+}
+
+
+void bignum_mod_dbl(const struct bn* a, const struct bn* m, struct bn* c)
+{
+  require(a, "a is null");
+  require(m, "m is null");
+  require(c, "c is null");
+
+  const int n = _nlimbs(m);
+  _mod_add(c, a, a, m, n);
+  _clear_above(c, n);
+}
+
+
+/* c = (a + b) mod m over n limbs, for a, b < m; c may alias a or b */
+static void _mod_add(struct bn* c, const struct bn* a, const struct bn* b, const struct bn* m, int n)
+{
+  DTYPE sum[BN_ARRAY_SIZE];
+  DTYPE_TMP tmp;
+  DTYPE carry = 0;
+  DTYPE borrow = 0;
+  int i;
+
+  for (i = 0; i < n; ++i)
+  {
+    tmp = (DTYPE_TMP)a->array[i] + b->array[i] + carry;
+    sum[i] = (DTYPE)tmp;
+    carry = (DTYPE)(tmp >> (8 * WORD_SIZE));
+  }
+  for (i = 0; i < n; ++i)
+  {
+    tmp = (DTYPE_TMP)sum[i] - m->array[i] - borrow;
+    c->array[i] = (DTYPE)tmp;
+    borrow = (tmp > MAX_VAL);
+  }
+
+  /* Keep the sum when it is below m: no carry out, yet subtracting m borrowed */
+  const DTYPE keep = (DTYPE)0 - (DTYPE)(borrow > carry);
+  for (i = 0; i < n; ++i)
+  {
+    c->array[i] = (sum[i] & keep) | (c->array[i] & ~keep);
+  }
+}
+
+
+/* c = (a - b) mod m over n limbs, for a, b < m; c may alias a or b */
+static void _mod_sub(struct bn* c, const struct bn* a, const struct bn* b, const struct bn* m, int n)
+{
+  DTYPE_TMP tmp;
+  DTYPE borrow = 0;
+  DTYPE carry = 0;
+  int i;
+
+  for (i = 0; i < n; ++i)
+  {
+    tmp = (DTYPE_TMP)a->array[i] - b->array[i] - borrow;
+    c->array[i] = (DTYPE)tmp;
+    borrow = (tmp > MAX_VAL);
+  }
+
+  /* Add m back when a < b */
+  const DTYPE mask = (DTYPE)0 - borrow;
+  for (i = 0; i < n; ++i)
+  {
+    tmp = (DTYPE_TMP)c->array[i] + (m->array[i] & mask) + carry;
+    c->array[i] = (DTYPE)tmp;
+    carry = (DTYPE)(tmp >> (8 * WORD_SIZE));
+  }
+}
+
+
+static void _clear_above(struct bn* a, int n)
+{
+  int i;
+  for (i = n; i < BN_ARRAY_SIZE; ++i)
+  {
+    a->array[i] = 0;
+  }
+}
+
+
+/*
+  Cache of the Montgomery contexts of recent moduli, so that bignum_pow_mod() with a recurring
+  modulus skips _mont_consts(). Each slot is a sequence lock: readers copy the context out and
+  retry elsewhere when the sequence moved, so lookups never wait. One writer at a time replaces
+  the least recently used slot; a writer that finds another at work skips its insertion.
+*/
+#if (BN_MODCACHE_SIZE > 0)
+struct _modcache_slot
+{
+  unsigned long seq;    /* odd while the slot is being written */
+  unsigned long hash;   /* _modcache_hash() of ctx.m, zero for an empty slot */
+  unsigned long used;   /* _modcache.clock at the last hit */
+  struct bn_mont ctx;
+};
+
+static struct
+{
+  struct _modcache_slot slots[BN_MODCACHE_SIZE];
+  unsigned long clock;
+  unsigned long hits;
+  unsigned long misses;
+  char writer;
+} _modcache;
+#endif
+
+
+void bignum_modcache_stats(unsigned long* hits, unsigned long* misses)
+{
+  require(hits, "hits is null");
+  require(misses, "misses is null");
+
+#if (BN_MODCACHE_SIZE > 0)
+  *hits = __atomic_load_n(&_modcache.hits, __ATOMIC_RELAXED);
+  *misses = __atomic_load_n(&_modcache.misses, __ATOMIC_RELAXED);
+#else
+  *hits = 0;
+  *misses = 0;
+#endif
+}
+
+
+void bignum_modcache_clear(void)
+{
+#if (BN_MODCACHE_SIZE > 0)
+  int i;
+
+  while (__atomic_test_and_set(&_modcache.writer, __ATOMIC_ACQUIRE))
+  {
+  }
+  for (i = 0; i < BN_MODCACHE_SIZE; ++i)
+  {
+    struct _modcache_slot* slot = &_modcache.slots[i];
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot->hash, 0, __ATOMIC_RELAXED);
+    slot->used = 0;
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+  }
+  __atomic_store_n(&_modcache.hits, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&_modcache.misses, 0, __ATOMIC_RELAXED);
+  __atomic_clear(&_modcache.writer, __ATOMIC_RELEASE);
+#endif
+}
+
+
+/* Copies the cached context of m into ctx: 1 on a hit, 0 on a miss */
+static int _modcache_get(const struct bn* m, struct bn_mont* ctx)
+{
+#if (BN_MODCACHE_SIZE > 0)
+  const unsigned long hash = _modcache_hash(m);
+  int i;
+
+  for (i = 0; i < BN_MODCACHE_SIZE; ++i)
+  {
+    struct _modcache_slot* slot = &_modcache.slots[i];
+    if (__atomic_load_n(&slot->hash, __ATOMIC_RELAXED) != hash)
+    {
+      continue;
+    }
+    const unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if (seq & 1)
+    {
+      continue;
+    }
+    memcpy(ctx, &slot->ctx, sizeof(*ctx));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if ((__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq) && (bignum_cmp(&ctx->m, m) == EQUAL))
+    {
+      __atomic_store_n(&slot->used, __atomic_add_fetch(&_modcache.clock, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+      __atomic_add_fetch(&_modcache.hits, 1, __ATOMIC_RELAXED);
+      return 1;
+    }
+  }
+  __atomic_add_fetch(&_modcache.misses, 1, __ATOMIC_RELAXED);
+#else
+  (void)m;
+  (void)ctx;
+#endif
+  return 0;
+}
+
+
+/* Stores ctx in the least recently used slot, unless another thread is storing or already stored it */
+static void _modcache_put(const struct bn_mont* ctx)
+{
+#if (BN_MODCACHE_SIZE > 0)
+  const unsigned long hash = _modcache_hash(&ctx->m);
+  struct _modcache_slot* victim = &_modcache.slots[0];
+  int i;
+
+  if (__atomic_test_and_set(&_modcache.writer, __ATOMIC_ACQUIRE))
+  {
+    return;
+  }
+  for (i = 0; i < BN_MODCACHE_SIZE; ++i)
+  {
+    struct _modcache_slot* slot = &_modcache.slots[i];
+    if ((slot->hash == hash) && (bignum_cmp(&slot->ctx.m, &ctx->m) == EQUAL))
+    {
+      victim = NULL;
+      break;
+    }
+    if (__atomic_load_n(&slot->used, __ATOMIC_RELAXED) < __atomic_load_n(&victim->used, __ATOMIC_RELAXED))
+    {
+      victim = slot;
+    }
+  }
+  if (victim)
+  {
+    __atomic_store_n(&victim->seq, victim->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&victim->ctx, ctx, sizeof(*ctx));
+    __atomic_store_n(&victim->hash, hash, __ATOMIC_RELAXED);
+    __atomic_store_n(&victim->used, __atomic_add_fetch(&_modcache.clock, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_store_n(&victim->seq, victim->seq + 1, __ATOMIC_RELEASE);
+  }
+  __atomic_clear(&_modcache.writer, __ATOMIC_RELEASE);
+#else
+  (void)ctx;
+#endif
+}
+
+
+#if (BN_MODCACHE_SIZE > 0)
+/* FNV-1a over the significant limbs of m, never zero */
+static unsigned long _modcache_hash(const struct bn* m)
+{
+  const int n = _nlimbs(m);
+  unsigned long hash = 2166136261UL;
+  int i;
+
+  for (i = 0; i < n; ++i)
+  {
+    hash = (hash ^ m->array[i]) * 16777619UL;
+  }
+  return hash | 1;
+}
+#endif
+
+
+/*
+  Chains of modular multiplications by an odd modulus, kept in Montgomery form in between so
+  that only the ends pay for the conversion. Values in the chain are only reduced below 2m
+  (lazy reduction) when m leaves two bits of room; bignum_from_mont() always returns a < m.
+*/
+int bignum_mont_init(struct bn_mont* ctx, const struct bn* m)
+{
+  require(ctx, "ctx is null");
+  require(m, "m is null");
+
+  if (!(m->array[0] & 1) || ((_nlimbs(m) == 1) && (m->array[0] == 1)))
+  {
+    return BN_INVALID;
+  }
+  _mont_init(ctx, m, 1);
+  return BN_OK;
+}
+
+
+void bignum_to_mont(const struct bn* a, const struct bn_mont* ctx, struct bn* x)
+{
+  require(a, "a is null");
+  require(ctx, "ctx is null");
+  require(x, "x is null");
+
+  struct bn t;
+  if (_nlimbs(a) > ctx->nlimbs)
+  {
+    bignum_mod(a, &ctx->m, &t);
+    a = &t;
+  }
+  /* a < R and R^2 mod m < m keep the product below 2m */
+  _mont_mul(x, a, &ctx->r2, ctx);
+  _clear_above(x, ctx->nlimbs);
+}
+
+
+void bignum_from_mont(const struct bn* x, const struct bn_mont* ctx, struct bn* a)
+{
+  require(x, "x is null");
+  require(ctx, "ctx is null");
+  require(a, "a is null");
+
+  /* x * 1 * R^-1 < m + 1, so the last subtraction brings it below m */
+  struct bn one;
+  bignum_from_int(&one, 1);
+  _mont_mul(a, x, &one, ctx);
+  _mont_redc(a, a->array, 0, ctx, 1);
+  _clear_above(a, ctx->nlimbs);
+}
+
+
+void bignum_mont_mul(const struct bn* x, const struct bn* y, const struct bn_mont* ctx, struct bn* z)
+{
+  require(x, "x is null");
+  require(y, "y is null");
+  require(ctx, "ctx is null");
+  require(z, "z is null");
+
+  _mont_mul(z, x, y, ctx);
+  _clear_above(z, ctx->nlimbs);
+}
+
+
+void bignum_mont_sqr(const struct bn* x, const struct bn_mont* ctx, struct bn* z)
+{
+  require(x, "x is null");
+  require(ctx, "ctx is null");
+  require(z, "z is null");
+
+  _mont_sqr(z, x, ctx);
+  _clear_above(z, ctx->nlimbs);
+}
+
+
+void bignum_mont_add(const struct bn* x, const struct bn* y, const struct bn_mont* ctx, struct bn* z)
+{
+  require(x, "x is null");
+  require(y, "y is null");
+  require(ctx, "ctx is null");
+  require(z, "z is null");
+
+  _mod_add(z, x, y, &ctx->bound, ctx->nlimbs);
+  _clear_above(z, ctx->nlimbs);
+}
+
+
+void bignum_mont_sub(const struct bn* x, const struct bn* y, const struct bn_mont* ctx, struct bn* z)
+{
+  require(x, "x is null");
+  require(y, "y is null");
+  require(ctx, "ctx is null");
+  require(z, "z is null");
+
+  _mod_sub(z, x, y, &ctx->bound, ctx->nlimbs);
+  _clear_above(z, ctx->nlimbs);
+}
+
+
+/*
+  Lane-interleaved Montgomery exponentiation.
+
+  Several independent modular exponentiations are computed side by side in a
+  structure-of-arrays layout: limb j of every lane is stored contiguously, so
+  that the innermost loops run across lanes with no dependency between
+  iterations and can be mapped onto SIMD registers by the compiler.
+  All lanes execute the same sequence of squarings and multiplications, lanes
+  whose exponent bit is clear are multiplied by one (in Montgomery form).
+
+  Montgomery reduction needs an odd modulus, lanes with an even modulus (or one
+  smaller than 2) are computed with bignum_pow_mod() instead.
+*/
+#define BN_MAX_LANES 8
+
+/* Limb j of lane l is lanes[j][l] -- two spare limbs for the reduction carries */
+typedef DTYPE bn_lanes[BN_ARRAY_SIZE + 2][BN_MAX_LANES];
+
+/* r = a * b * R^-1 mod m for each lane, where R = 2^(8 * WORD_SIZE * nlimbs) */
+static void _mont_mul_lanes(bn_lanes r, bn_lanes a, bn_lanes b, bn_lanes m, const DTYPE* minv, int nlimbs, int nlanes)
+{
+  const int nbits = (8 * WORD_SIZE);
+  bn_lanes t;
+  DTYPE carry[BN_MAX_LANES];
+  DTYPE u[BN_MAX_LANES];
+  DTYPE_TMP tmp;
+  int i, j, l;
+
+  for (j = 0; j < nlimbs + 2; ++j)
+  {
+    for (l = 0; l < nlanes; ++l)
+    {
+      t[j][l] = 0;
+    }
+  }
+
+  for (i = 0; i < nlimbs; ++i)
+  {
+    /* t += a[i] * b */
+    for (l = 0; l < nlanes; ++l)
+    {
+      carry[l] = 0;
+    }
+    for (j = 0; j < nlimbs; ++j)
+    {
+      for (l = 0; l < nlanes; ++l)
+      {
+        tmp = (DTYPE_TMP)a[i][l] * b[j][l] + t[j][l] + carry[l];
+        t[j][l] = (DTYPE)tmp;
+        carry[l] = (DTYPE)(tmp >> nbits);
+      }
+    }
+    for (l = 0; l < nlanes; ++l)
+    {
+      tmp = (DTYPE_TMP)t[nlimbs][l] + carry[l];
+      t[nlimbs][l] = (DTYPE)tmp;
+      t[nlimbs + 1][l] = (DTYPE)(tmp >> nbits);
+    }
+
+    /* t = (t + u * m) / 2^nbits, with u chosen so that the low limb cancels */
+    for (l = 0; l < nlanes; ++l)
+    {
+      u[l] = (DTYPE)(t[0][l] * minv[l]);
+      tmp = (DTYPE_TMP)u[l] * m[0][l] + t[0][l];
+      carry[l] = (DTYPE)(tmp >> nbits);
+    }
+    for (j = 1; j < nlimbs; ++j)
+    {
+      for (l = 0; l < nlanes; ++l)
+      {
+        tmp = (DTYPE_TMP)u[l] * m[j][l] + t[j][l] + carry[l];
+        t[j - 1][l] = (DTYPE)tmp;
+        carry[l] = (DTYPE)(tmp >> nbits);
+      }
+    }
+    for (l = 0; l < nlanes; ++l)
+    {
+      tmp = (DTYPE_TMP)t[nlimbs][l] + carry[l];
+      t[nlimbs - 1][l] = (DTYPE)tmp;
+      t[nlimbs][l] = t[nlimbs + 1][l] + (DTYPE)(tmp >> nbits);
+    }
+  }
+
+  /* t < 2m: subtract m once, keep the difference unless it borrowed */
+  DTYPE borrow[BN_MAX_LANES];
+  for (l = 0; l < nlanes; ++l)
+  {
+    borrow[l] = 0;
+  }
+  for (j = 0; j < nlimbs; ++j)
+  {
+    for (l = 0; l < nlanes; ++l)
+    {
+      tmp = (DTYPE_TMP)t[j][l] - m[j][l] - borrow[l];
+      r[j][l] = (DTYPE)tmp;
+      borrow[l] = (DTYPE)((tmp >> nbits) & 1);
+    }
+  }
+  for (l = 0; l < nlanes; ++l)
+  {
+    /* all ones when t < m, i.e. the subtraction borrowed past the top limb */
+    DTYPE keep = (DTYPE)0 - (DTYPE)(borrow[l] > t[nlimbs][l]);
+    for (j = 0; j < nlimbs; ++j)
+    {
+      r[j][l] = (t[j][l] & keep) | (r[j][l] & ~keep);
+    }
+  }
+}
+
+
+static void _pow_mod_lanes(const struct bn* a, const struct bn* b, const struct bn* n, struct bn* res, int nlanes)
+{
+  bn_lanes m, acc, base, one, tmp;
+  DTYPE minv[BN_MAX_LANES];
+  int fast[BN_MAX_LANES];
+  int nlimbs = 1;
+  int nexpbits = 0;
+  int i, j, l;
+
+  /* Pick the lanes that can use Montgomery reduction and the common width */
+  for (l = 0; l < nlanes; ++l)
+  {
+    fast[l] = ((n[l].array[0] & 1) && (_nlimbs(&n[l]) > 1 || n[l].array[0] > 1));
+    if (fast[l])
+    {
+      j = _nlimbs(&n[l]);
+      nlimbs = (j > nlimbs) ? j : nlimbs;
+      j = _nbits(&b[l]);
+      nexpbits = (j > nexpbits) ? j : nexpbits;
+    }
+    else
+    {
+      bignum_pow_mod(&a[l], &b[l], &n[l], &res[l]);
+    }
+  }
+
+  /* Load the fast lanes in Montgomery form, idle lanes compute modulo 1 */
+  for (l = 0; l < nlanes; ++l)
+  {
+    struct bn tm, ta, tone, tr2;
+    if (fast[l])
+    {
+      bignum_assign(&tm, &n[l]);
+      bignum_mod(&a[l], &n[l], &ta);
+    }
+    else
+    {
+      bignum_from_int(&tm, 1);
+      bignum_init(&ta);
+    }
+    minv[l] = _mont_minv(tm.array[0]);
+    _mont_consts(&tm, nlimbs, &tone, &tr2);
+    for (j = 0; j < nlimbs; ++j)
+    {
+      m[j][l] = tm.array[j];
+      base[j][l] = ta.array[j];
+      tmp[j][l] = tr2.array[j];
+      one[j][l] = tone.array[j];
+      acc[j][l] = tone.array[j];
+    }
+  }
+  _mont_mul_lanes(base, base, tmp, m, minv, nlimbs, nlanes);
+
+  /* Left-to-right square-and-multiply, in lock-step across lanes */
+  for (i = nexpbits - 1; i >= 0; --i)
+  {
+    const int word = i / (8 * WORD_SIZE);
+    const int bit = i % (8 * WORD_SIZE);
+    int any = 0;
+
+    _mont_mul_lanes(acc, acc, acc, m, minv, nlimbs, nlanes);
+    for (l = 0; l < nlanes; ++l)
+    {
+      DTYPE take = (DTYPE)0 - (DTYPE)(fast[l] && ((b[l].array[word] >> bit) & 1));
+      any |= (take != 0);
+      for (j = 0; j < nlimbs; ++j)
+      {
+        tmp[j][l] = (base[j][l] & take) | (one[j][l] & ~take);
+      }
+    }
+    if (any)
+    {
+      _mont_mul_lanes(acc, acc, tmp, m, minv, nlimbs, nlanes);
+    }
+  }
+
+  /* Leave Montgomery form: multiply by plain 1 */
+  for (j = 0; j < nlimbs; ++j)
+  {
+    for (l = 0; l < nlanes; ++l)
+    {
+      tmp[j][l] = (j == 0);
+    }
+  }
+  _mont_mul_lanes(acc, acc, tmp, m, minv, nlimbs, nlanes);
+
+  for (l = 0; l < nlanes; ++l)
+  {
+    if (fast[l])
+    {
+      bignum_init(&res[l]);
+      for (j = 0; j < nlimbs; ++j)
+      {
+        res[l].array[j] = acc[j][l];
+      }
+    }
+  }
+}
+
+
+void bignum_pow_mod_x4(const struct bn a[4], const struct bn b[4], const struct bn n[4], struct bn res[4])
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(n, "n is null");
+  require(res, "res is null");
+
+  _pow_mod_lanes(a, b, n, res, 4);
+}
+
+
+void bignum_pow_mod_x8(const struct bn a[8], const struct bn b[8], const struct bn n[8], struct bn res[8])
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(n, "n is null");
+  require(res, "res is null");
+
+  _pow_mod_lanes(a, b, n, res, 8);
+}
+
+
+/*
+  Greatest common divisor and modular inverse.
+
+  Both are binary algorithms (Stein): common factors of two come out with one
+  word-level shift by the count of trailing zeros, and the odd parts are
+  reduced by subtraction, never by division. All loops only touch the limbs
+  that the operands occupy.
+
+  The inverse follows u = a, v = m down to u = 0, v = gcd(a, m), keeping the
+  coefficients x1, x2 with a * x1 == u and a * x2 == v (mod m). Dividing u by
+  2^k turns into x1 * 2^-k mod m, done k bits at a time like a Montgomery
+  reduction step. That needs an odd m; an even modulus m = 2^s * o is solved
+  modulo o and modulo 2^s (by Newton iteration) and the two are combined.
+*/
+void bignum_gcd(const struct bn* a, const struct bn* b, struct bn* g)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(g, "g is null");
+
+  struct bn u, v;
+  struct bn* pu = &u;
+  struct bn* pv = &v;
+  struct bn* tmp;
+
+  if (bignum_is_zero(a) || bignum_is_zero(b))
+  {
+    bignum_or(a, b, g);
+    return;
+  }
+
+  bignum_assign(&u, a);
+  bignum_assign(&v, b);
+
+  /* Large operands shrink a limb at a time first, while gcd(u, v) stays the same */
+  if (_nbits(&u) >= BN_GCD_LEHMER_THRESHOLD || _nbits(&v) >= BN_GCD_LEHMER_THRESHOLD)
+  {
+    _gcd_lehmer(pu, pv);
+    if (bignum_is_zero(pv))
+    {
+      bignum_assign(g, pu);
+      return;
+    }
+  }
+
+  int n = _nlimbs(pu);
+  if (_nlimbs(pv) > n)
+  {
+    n = _nlimbs(pv);
+  }
+
+  /* gcd(2^i * u, 2^j * v) = 2^min(i, j) * gcd(u, v) for odd u, v */
+  const int ku = _ctz(pu);
+  const int kv = _ctz(pv);
+  _shr_limbs(pu, ku, n);
+  _shr_limbs(pv, kv, n);
+
+  while (1)
+  {
+    const int cmp = _cmp_limbs(pu, pv, n);
+    if (cmp == EQUAL)
+    {
+      break;
+    }
+    if (cmp == LARGER)
+    {
+      tmp = pu;
+      pu = pv;
+      pv = tmp;
+    }
+
+    /* gcd(u, v) = gcd(u, (v - u) / 2^k), the difference of two odd numbers is even */
+    _sub_limbs(pv, pu, n);
+    _shr_limbs(pv, _ctz(pv), n);
+    while ((n > 1) && (pu->array[n - 1] == 0) && (pv->array[n - 1] == 0))
+    {
+      n -= 1;
+    }
+  }
+
+  bignum_lshift(pu, g, (ku < kv) ? ku : kv);
+}
+
+
+void bignum_gcdext(const struct bn* a, const struct bn* b, struct bn* g, struct bn* x, struct bn* y)
+{
+  require(a, "a is null");
+  require(b, "b is null");
+  require(g, "g is null");
+  require(x, "x is null");
+  require(y, "y is null");
+
+  struct bn gg, ap, bp, xx, yy, one;
+
+  bignum_gcd(a, b, &gg);
+  bignum_from_int(&one, 1);
+
+  if (bignum_is_zero(a))
+  {
+    bignum_init(&xx);
+    bignum_init(&yy);
+  }
+  else if (bignum_is_zero(b))
+  {
+    bignum_from_int(&xx, 1);
+    bignum_init(&yy);
+  }
+  else
+  {
+    /*
+      With a = g * a' and b = g * b', a' * x - b' * y = 1 fixes x modulo b' and y modulo a':
+      x = a'^-1 mod b' and y = -(b'^-1) mod a', no product of the two sizes needed.
+    */
+    bignum_div(a, &gg, &ap);
+    bignum_div(b, &gg, &bp);
+    if (bignum_cmp(&bp, &one) == EQUAL)
+    {
+      bignum_from_int(&xx, 1);
+    }
+    else
+    {
+      bignum_modinv(&ap, &bp, &xx);
+    }
+    if (bignum_cmp(&ap, &one) == EQUAL)
+    {
+      bignum_init(&yy);
+    }
+    else
+    {
+      bignum_modinv(&bp, &ap, &yy);
+      bignum_sub(&ap, &yy, &yy);
+    }
+  }
+
+  bignum_assign(g, &gg);
+  bignum_assign(x, &xx);
+  bignum_assign(y, &yy);
+}
+
+
+int bignum_modinv(const struct bn* a, const struct bn* m, struct bn* inv)
+{
+  require(a, "a is null");
+  require(m, "m is null");
+  require(inv, "inv is null");
+  require(!bignum_is_zero(m), "modulus is zero");
+
+  struct bn o, xo, x2, oinv, t;
+  int status;
+
+  if (m->array[0] & 1)
+  {
+    return _modinv_odd(a, m, inv);
+  }
+  if ((a->array[0] & 1) == 0)
+  {
+    return BN_INVALID;
+  }
+
+  /* m = 2^s * o: x = xo + o * ((x2 - xo) * o^-1 mod 2^s) is xo modulo o and x2 modulo 2^s */
+  const int s = _ctz(m);
+  bignum_rshift(m, &o, s);
+  status = _modinv_odd(a, &o, &xo);
+  if (status != BN_OK)
+  {
+    return status;
+  }
+  _inv_pow2(a, s, &x2);
+  _inv_pow2(&o, s, &oinv);
+
+  bignum_sub(&x2, &xo, &t);
+  bignum_mul(&t, &oinv, &t);
+  _truncate_bits(&t, s);
+  bignum_mul(&o, &t, &t);
+  bignum_add(&xo, &t, inv);
+  return BN_OK;
+}
+
+
+/*
+  Montgomery's trick: out[i] first holds the prefix product in[0] * ... * in[i] mod m, the
+  single inversion of the last one is then peeled back into the inverses of the elements
+  one at a time, for 3 * (count - 1) multiplications in all.
+*/
+int bignum_modinv_batch(const struct bn* in, struct bn* out, size_t count, const struct bn* m)
+{
+  require(in, "in is null");
+  require(out, "out is null");
+  require(m, "m is null");
+  require(in != out, "in and out overlap");
+
+  struct bn inv, t;
+  size_t i;
+  int status;
+
+  if (count == 0)
+  {
+    return BN_OK;
+  }
+
+  bignum_mod(&in[0], m, &out[0]);
+  for (i = 1; i < count; ++i)
+  {
+    bignum_mul(&out[i - 1], &in[i], &t);
+    bignum_mod(&t, m, &out[i]);
+  }
+
+  status = bignum_modinv(&out[count - 1], m, &inv);
+  if (status != BN_OK)
+  {
+    return status;
+  }
+
+  /* inv = (in[0] * ... * in[i])^-1 going in, so in[i]^-1 = inv * out[i - 1] */
+  for (i = count - 1; i > 0; --i)
+  {
+    bignum_mul(&inv, &out[i - 1], &t);
+    bignum_mod(&t, m, &out[i]);
+    bignum_mul(&inv, &in[i], &t);
+    bignum_mod(&t, m, &inv);
+  }
+  bignum_assign(&out[0], &inv);
+  return BN_OK;
+}
+
+
+/*
+  Lehmer's algorithm: the quotients of Euclid's algorithm on u and v mostly depend on their
+  leading bits only. Running it on the top two limbs of each, for as long as both ends of the
+  interval the true ratio lies in agree on the quotient, yields a matrix of single-limb
+  cofactors; applying that to the full numbers in one pass replaces a whole run of division
+  steps. Stops once the larger number is below BN_GCD_LEHMER_THRESHOLD bits or v is zero.
+*/
+static void _gcd_lehmer(struct bn* u, struct bn* v)
+{
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  const int lead = (2 * nbits_pr_word < 62) ? (2 * nbits_pr_word) : 62;
+  struct bn t[2];
+  struct bn* pu = u;
+  struct bn* pv = v;
+  struct bn* nu = &t[0];
+  struct bn* nv = &t[1];
+  struct bn* tmp;
+  int64_t m[4];
+
+  while (!bignum_is_zero(pv))
+  {
+    if (bignum_cmp(pu, pv) == SMALLER)
+    {
+      tmp = pu;
+      pu = pv;
+      pv = tmp;
+    }
+
+    const int nbits = _nbits(pu);
+    if (nbits < BN_GCD_LEHMER_THRESHOLD)
+    {
+      break;
+    }
+
+    /* The top two limbs' worth of bits of u (short of overflowing int64_t), and the bits of v at the same position */
+    const int shift = (nbits > lead) ? (nbits - lead) : 0;
+    const uint64_t x = ((uint64_t)_bits_at(pu, shift + nbits_pr_word) << nbits_pr_word) | _bits_at(pu, shift);
+    const uint64_t y = ((uint64_t)_bits_at(pv, shift + nbits_pr_word) << nbits_pr_word) | _bits_at(pv, shift);
+    if (!_lehmer_matrix(x, y, m))
+    {
+      /* Not even one quotient is certain, e.g. v much smaller than u: take a full division step */
+      bignum_mod(pu, pv, nu);
+      tmp = pu;
+      pu = pv;
+      pv = nu;
+      nu = tmp;
+      continue;
+    }
+
+    const int n = _nlimbs(pu);
+    _lehmer_row(nu, pu, pv, m[0], m[1], n);
+    _lehmer_row(nv, pu, pv, m[2], m[3], n);
+    tmp = pu;
+    pu = nu;
+    nu = tmp;
+    tmp = pv;
+    pv = nv;
+    nv = tmp;
+  }
+
+  /* Hand back the results, which may have ended up in any of the four */
+  struct bn ru, rv;
+  bignum_assign(&ru, pu);
+  bignum_assign(&rv, pv);
+  bignum_assign(u, &ru);
+  bignum_assign(v, &rv);
+}
+
+
+/*
+  Euclid's algorithm on the leading bits x >= y, as in Knuth's algorithm L. Collects the
+  cofactors { A, B, C, D } with u' = A*u + B*v and v' = C*u + D*v in m, as long as they fit
+  a limb; returns zero if not a single step could be taken.
+*/
+static int _lehmer_matrix(uint64_t x, uint64_t y, int64_t* m)
+{
+  const int64_t limit = (int64_t)MAX_VAL; /* cofactors must fit a limb */
+  int64_t xx = (int64_t)x, yy = (int64_t)y;
+  int64_t a = 1, b = 0, c = 0, d = 1;
+  int64_t q, t, nc, nd;
+
+  while (((yy + c) > 0) && ((yy + d) > 0) && ((xx + a) >= 0) && ((xx + b) >= 0))
+  {
+    q = (xx + a) / (yy + c);
+    if (q != ((xx + b) / (yy + d)))
+    {
+      break;
+    }
+    nc = a - (q * c);
+    nd = b - (q * d);
+    if ((nc > limit) || (-nc > limit) || (nd > limit) || (-nd > limit))
+    {
+      break;
+    }
+    a = c;
+    b = d;
+    c = nc;
+    d = nd;
+    t = xx - (q * yy);
+    xx = yy;
+    yy = t;
+  }
+
+  m[0] = a;
+  m[1] = b;
+  m[2] = c;
+  m[3] = d;
+  return (b != 0);
+}
+
+
+/* out = a*u + b*v for cofactors of opposite signs, whose result is known to be non-negative */
+static void _lehmer_row(struct bn* out, const struct bn* u, const struct bn* v, int64_t a, int64_t b, int n)
+{
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  const struct bn* x = (b <= 0) ? u : v;
+  const struct bn* y = (b <= 0) ? v : u;
+  const DTYPE p = (DTYPE)((b <= 0) ? a : b);
+  const DTYPE q = (DTYPE)((b <= 0) ? -b : -a);
+  DTYPE_TMP cp = 0, cq = 0, tp, tq, tmp;
+  DTYPE borrow = 0;
+  int i;
+
+  /* out = p*x - q*y */
+  bignum_init(out);
+  for (i = 0; i < n; ++i)
+  {
+    tp = ((DTYPE_TMP)p * x->array[i]) + cp;
+    tq = ((DTYPE_TMP)q * y->array[i]) + cq;
+    cp = (tp >> nbits_pr_word);
+    cq = (tq >> nbits_pr_word);
+    tmp = (DTYPE_TMP)(DTYPE)tp - (DTYPE)tq - borrow;
+    out->array[i] = (DTYPE)tmp;
+    borrow = (tmp > MAX_VAL);
+  }
+}
+
+
+/* (a >> shift) mod 2^(8 * WORD_SIZE) */
+static DTYPE _bits_at(const struct bn* a, int shift)
+{
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  const int i = shift / nbits_pr_word;
+  const int bits = shift % nbits_pr_word;
+  const DTYPE_TMP hi = (i + 1 < BN_ARRAY_SIZE) ? a->array[i + 1] : 0;
+  return (DTYPE)(((DTYPE_TMP)a->array[i] >> bits) | (hi << (nbits_pr_word - bits)));
+}
+
+
+/* Number of trailing zero bits of a != 0 */
+static int _ctz(const struct bn* a)
+{
+  int i = 0;
+  int k = 0;
+  while (a->array[i] == 0)
+  {
+    i += 1;
+  }
+  DTYPE w = a->array[i];
+  while ((w & 1) == 0)
+  {
+    w >>= 1;
+    k += 1;
+  }
+  return (i * 8 * WORD_SIZE) + k;
+}
+
+
+/* a >>= nbits, for a of n limbs */
+static void _shr_limbs(struct bn* a, int nbits, int n)
+{
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  const int words = nbits / nbits_pr_word;
+  const int bits = nbits % nbits_pr_word;
+  int i;
+
+  for (i = 0; i < n; ++i)
+  {
+    const DTYPE_TMP lo = (i + words < n) ? a->array[i + words] : 0;
+    const DTYPE_TMP hi = (i + words + 1 < n) ? a->array[i + words + 1] : 0;
+    a->array[i] = (DTYPE)((lo >> bits) | (hi << (nbits_pr_word - bits)));
+  }
+}
+
+
+/* a -= b over n limbs, returns the borrow */
+static DTYPE _sub_limbs(struct bn* a, const struct bn* b, int n)
+{
+  DTYPE_TMP tmp;
+  DTYPE borrow = 0;
+  int i;
+
+  for (i = 0; i < n; ++i)
+  {
+    tmp = (DTYPE_TMP)a->array[i] - b->array[i] - borrow;
+    a->array[i] = (DTYPE)tmp;
+    borrow = (tmp > MAX_VAL);
+  }
+  return borrow;
+}
+
+
+static int _cmp_limbs(const struct bn* a, const struct bn* b, int n)
+{
+  int i;
+  for (i = n - 1; i >= 0; --i)
+  {
+    if (a->array[i] != b->array[i])
+    {
+      return (a->array[i] > b->array[i]) ? LARGER : SMALLER;
+    }
+  }
+  return EQUAL;
+}
+
+
+/*
+  x = x / 2^k mod m, for odd m and x < m of n limbs, where minv = -m^-1 mod 2^(8 * WORD_SIZE).
+  Adding q * m with q = x * minv mod 2^j makes the low j bits zero, so they shift out exactly.
+*/
+static void _mod_halve(struct bn* x, int k, const struct bn* m, DTYPE minv, int n)
+{
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  DTYPE t[BN_ARRAY_SIZE + 1];
+  DTYPE_TMP tmp;
+  DTYPE carry;
+  int i;
+
+  while (k > 0)
+  {
+    const int j = (k < nbits_pr_word) ? k : (nbits_pr_word - 1);
+    const DTYPE q = (DTYPE)((DTYPE)(x->array[0] * minv) & (((DTYPE_TMP)1 << j) - 1));
+
+    carry = 0;
+    for (i = 0; i < n; ++i)
+    {
+      tmp = ((DTYPE_TMP)q * m->array[i]) + x->array[i] + carry;
+      t[i] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> nbits_pr_word);
+    }
+    t[n] = carry;
+
+    /* (x + q * m) / 2^j < 2 * m */
+    for (i = 0; i < n; ++i)
+    {
+      x->array[i] = (DTYPE)(((DTYPE_TMP)t[i] >> j) | ((DTYPE_TMP)t[i + 1] << (nbits_pr_word - j)));
+    }
+    if ((t[n] >> j) || (_cmp_limbs(x, m, n) != SMALLER))
+    {
+      _sub_limbs(x, m, n);
+    }
+    k -= j;
+  }
+}
+
+
+/* inv = a^-1 mod m for odd m, see bignum_modinv() */
+static int _modinv_odd(const struct bn* a, const struct bn* m, struct bn* inv)
+{
+  struct bn s[4];
+  struct bn* u = &s[0];
+  struct bn* v = &s[1];
+  struct bn* x1 = &s[2];
+  struct bn* x2 = &s[3];
+  struct bn* tmp;
+  const int n = _nlimbs(m);
+  const DTYPE minv = _mont_minv(m->array[0]);
+  int k;
+
+  if ((n == 1) && (m->array[0] == 1))
+  {
+    bignum_init(inv);
+    return BN_OK;
+  }
+
+  bignum_mod(a, m, u);
+  bignum_assign(v, m);
+  bignum_from_int(x1, 1);
+  bignum_init(x2);
+
+  /* a * x1 == u and a * x2 == v (mod m), v odd */
+  while (!_is_zero_limbs(u, n))
+  {
+    k = _ctz(u);
+    _shr_limbs(u, k, n);
+    _mod_halve(x1, k, m, minv, n);
+
+    if (_cmp_limbs(u, v, n) != SMALLER)
+    {
+      _sub_limbs(u, v, n);
+      _mod_sub(x1, x1, x2, m, n);
+    }
+    else
+    {
+      /* v - u is the even one now: it becomes u, the odd u becomes v */
+      _sub_limbs(v, u, n);
+      _mod_sub(x2, x2, x1, m, n);
+      tmp = u;
+      u = v;
+      v = tmp;
+      tmp = x1;
+      x1 = x2;
+      x2 = tmp;
+    }
+  }
+
+  /* v = gcd(a, m) */
+  if ((_nlimbs(v) != 1) || (v->array[0] != 1))
+  {
+    return BN_INVALID;
+  }
+  bignum_assign(inv, x2);
+  return BN_OK;
+}
+
+
+/* inv = a^-1 mod 2^s for odd a, by Newton iteration from the inverse of the low limb */
+static void _inv_pow2(const struct bn* a, int s, struct bn* inv)
+{
+  struct bn t, two;
+  int bits;
+
+  bignum_from_int(inv, (DTYPE)(0 - _mont_minv(a->array[0])));
+  bignum_from_int(&two, 2);
+  for (bits = 8 * WORD_SIZE; bits < s; bits *= 2)
+  {
+    /* inv = inv * (2 - a * inv), doubling the number of correct bits; truncation is harmless */
+    bignum_mul(a, inv, &t);
+    bignum_sub(&two, &t, &t);
+    bignum_mul(inv, &t, inv);
+  }
+  _truncate_bits(inv, s);
+}
+
+
+/* a = a mod 2^nbits */
+static void _truncate_bits(struct bn* a, int nbits)
+{
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  int i;
+
+  for (i = nbits / nbits_pr_word; i < BN_ARRAY_SIZE; ++i)
+  {
+    if (i == nbits / nbits_pr_word)
+    {
+      a->array[i] &= (DTYPE)(((DTYPE_TMP)1 << (nbits % nbits_pr_word)) - 1);
+    }
+    else
+    {
+      a->array[i] = 0;
+    }
+  }
+}
+
+
+static int _is_zero_limbs(const struct bn* a, int n)
+{
+  int i;
+  for (i = 0; i < n; ++i)
+  {
+    if (a->array[i])
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+
+/*
+  Primality testing.
+
+  Baillie-PSW: trial division by the primes below BN_PRIME_TRIAL_LIMIT, a strong
+  probable-prime (Miller-Rabin) test to base 2 and a strong Lucas test with the
+  parameters of Selfridge's method A. No composite passing both is known. Below
+  BN_PRIME_DETERMINISTIC_BITS bits the twelve prime bases up to 37 are known to
+  leave no strong pseudoprime, so Miller-Rabin alone is exact there.
+
+  All arithmetic runs in Montgomery form modulo n, on the limbs n occupies.
+*/
+int bignum_is_probable_prime(const struct bn* n)
+{
+  require(n, "n is null");
+
+  uint8_t composite[BN_PRIME_TRIAL_LIMIT / 16 + 1];
+  struct bn t;
+  DTYPE_TMP p;
+
+  /* 0, 1, 2 and the other even numbers */
+  if ((_nlimbs(n) == 1) && (n->array[0] < 3))
+  {
+    return (n->array[0] == 2);
+  }
+  if ((n->array[0] & 1) == 0)
+  {
+    return 0;
+  }
+
+  /* Trial division, which also settles every n below BN_PRIME_TRIAL_LIMIT^2 */
+  _sieve(BN_PRIME_TRIAL_LIMIT, composite);
+  for (p = 3; p < BN_PRIME_TRIAL_LIMIT; p += 2)
+  {
+    if (_is_odd_prime(p, composite) && (_mod_small(n, p) == 0))
+    {
+      bignum_from_int(&t, p);
+      return (bignum_cmp(n, &t) == EQUAL);
+    }
+  }
+  bignum_from_int(&t, (DTYPE_TMP)BN_PRIME_TRIAL_LIMIT * BN_PRIME_TRIAL_LIMIT);
+  if (bignum_cmp(n, &t) == SMALLER)
+  {
+    return 1;
+  }
+
+  return _bpsw(n);
+}
+
+
+/*
+  The residues of the first odd candidate modulo the odd primes below BN_PRIME_SIEVE_LIMIT
+  strike out the multiples of each prime from a window of BN_PRIME_SIEVE_WINDOW odd
+  candidates. Moving on to the next window advances every residue by a small addition, so
+  the number itself is divided by each prime only once. Starting points below the sieve
+  limit, where the sieve would strike out the small primes themselves, step through the
+  primes one by one instead.
+*/
+void bignum_sieve_init(struct bn_sieve* s, const struct bn* a)
+{
+  require(s, "s is null");
+  require(a, "a is null");
+
+  uint8_t composite[BN_PRIME_SIEVE_LIMIT / 16 + 1];
+  struct bn t;
+  uint32_t q;
+
+  bignum_assign(&s->base, a);
+  s->nprimes = 0;
+  s->next = 0;
+  s->status = BN_OK;
+
+  bignum_from_int(&t, BN_PRIME_SIEVE_LIMIT);
+  s->small = (bignum_cmp(a, &t) == SMALLER);
+  if (s->small)
+  {
+    return;
+  }
+
+  /* The first odd candidate above a */
+  bignum_inc(&s->base);
+  if (bignum_is_zero(&s->base))
+  {
+    s->status = BN_OVERFLOW;
+    return;
+  }
+  s->base.array[0] |= 1;
+
+  _sieve(BN_PRIME_SIEVE_LIMIT, composite);
+  for (q = 3; q < BN_PRIME_SIEVE_LIMIT; q += 2)
+  {
+    if (_is_odd_prime(q, composite))
+    {
+      s->primes[s->nprimes] = (uint16_t)q;
+      s->residues[s->nprimes] = (uint16_t)_mod_small(&s->base, q);
+      s->nprimes += 1;
+    }
+  }
+  _sieve_window(s);
+}
+
+
+int bignum_sieve_next(struct bn_sieve* s, struct bn* c)
+{
+  require(s, "s is null");
+  require(c, "c is null");
+
+  struct bn t;
+  int i;
+
+  if (s->small)
+  {
+    do
+    {
+      bignum_inc(&s->base);
+    } while (!bignum_is_probable_prime(&s->base));
+    bignum_assign(c, &s->base);
+    return BN_OK;
+  }
+
+  while (s->status == BN_OK)
+  {
+    for (; s->next < BN_PRIME_SIEVE_WINDOW; ++s->next)
+    {
+      if (!(s->window[s->next / 8] & (1 << (s->next % 8))))
+      {
+        bignum_from_int(&t, 2 * (DTYPE_TMP)s->next);
+        bignum_add(&s->base, &t, c);
+        s->next += 1;
+        if (bignum_cmp(c, &s->base) == SMALLER)
+        {
+          s->status = BN_OVERFLOW;
+          break;
+        }
+        return BN_OK;
+      }
+    }
+    if (s->status != BN_OK)
+    {
+      break;
+    }
+
+    /* Next window */
+    bignum_from_int(&t, 2 * (DTYPE_TMP)BN_PRIME_SIEVE_WINDOW);
+    bignum_add(&s->base, &t, c);
+    if (bignum_cmp(c, &s->base) == SMALLER)
+    {
+      s->status = BN_OVERFLOW;
+      break;
+    }
+    bignum_assign(&s->base, c);
+    for (i = 0; i < s->nprimes; ++i)
+    {
+      s->residues[i] = (uint16_t)((s->residues[i] + 2 * BN_PRIME_SIEVE_WINDOW) % s->primes[i]);
+    }
+    s->next = 0;
+    _sieve_window(s);
+  }
+  return s->status;
+}
+
+
+/* Sieve, then test: only the survivors go through _bpsw() */
+int bignum_next_prime(const struct bn* a, struct bn* p)
+{
+  require(a, "a is null");
+  require(p, "p is null");
+
+  struct bn_sieve s;
+  struct bn c;
+  int status;
+
+  bignum_sieve_init(&s, a);
+  while ((status = bignum_sieve_next(&s, &c)) == BN_OK)
+  {
+    /* Below the sieve limit the candidates are the primes already */
+    if (s.small || _bpsw(&c))
+    {
+      bignum_assign(p, &c);
+      return BN_OK;
+    }
+  }
+  return status;
+}
+
+
+int bignum_gen_prime(struct bn* p, int nbits, bn_random_fn rng, void* ctx)
+{
+  require(p, "p is null");
+  require(rng, "rng is null");
+
+  const int nbits_pr_word = (8 * WORD_SIZE);
+  uint8_t buf[BN_ARRAY_SIZE * WORD_SIZE];
+  const size_t nbytes = ((size_t)nbits + 7) / 8;
+  struct bn x;
+  int status;
+
+  if ((nbits < 2) || (nbits > BN_ARRAY_SIZE * nbits_pr_word))
+  {
+    return BN_INVALID;
+  }
+
+  for (;;)
+  {
+    status = rng(ctx, buf, nbytes);
+    if (status != BN_OK)
+    {
+      return status;
+    }
+    bignum_from_bytes_le(&x, buf, nbytes);
+    _truncate_bits(&x, nbits);
+
+    /* The top two bits set: the product of two such primes has exactly twice the bits */
+    x.array[(nbits - 1) / nbits_pr_word] |= (DTYPE)1 << ((nbits - 1) % nbits_pr_word);
+    x.array[(nbits - 2) / nbits_pr_word] |= (DTYPE)1 << ((nbits - 2) % nbits_pr_word);
+
+    /* The first prime from x on, unless that runs past nbits bits: then start over */
+    bignum_dec(&x);
+    if ((bignum_next_prime(&x, p) == BN_OK) && (_nbits(p) == nbits))
+    {
+      return BN_OK;
+    }
+  }
+}
+
+
+/* Binary algorithm: twos come out by shifting, odd values are reduced by subtraction and swapped by reciprocity */
+int bignum_jacobi(const struct bn* a, const struct bn* n)
+{
+  require(a, "a is null");
+  require(n, "n is null");
+  require(n->array[0] & 1, "n is even");
+
+  const int len = _nlimbs(n);
+  struct bn x, y;
+  struct bn* px = &x;
+  struct bn* py = &y;
+  struct bn* tmp;
+  int result = 1;
+  int k;
+
+  bignum_mod(a, n, &x);
+  bignum_assign(&y, n);
+
+  while (!_is_zero_limbs(px, len))
+  {
+    /* (2/y) = -1 exactly for y = 3, 5 mod 8 */
+    k = _ctz(px);
+    if (k > 0)
+    {
+      _shr_limbs(px, k, len);
+      if ((k & 1) && (((py->array[0] & 7) == 3) || ((py->array[0] & 7) == 5)))
+      {
+        result = -result;
+      }
+    }
+
+    /* Both odd: (x/y) = (y/x), unless both are 3 mod 4 */
+    if (_cmp_limbs(px, py, len) == SMALLER)
+    {
+      tmp = px;
+      px = py;
+      py = tmp;
+      if (((px->array[0] & 3) == 3) && ((py->array[0] & 3) == 3))
+      {
+        result = -result;
+      }
+    }
+    _sub_limbs(px, py, len);
+  }
+
+  return ((_nlimbs(py) == 1) && (py->array[0] == 1)) ? result : 0;
+}
+
+
+/* Primality of an odd n > 37 without the factor 3, e.g. after trial division */
+static int _bpsw(const struct bn* n)
+{
+  static const DTYPE bases[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+  struct bn_mont ctx;
+  struct bn d;
+  int s, i;
+
+  /* n - 1 = d * 2^s */
+  _mont_init(&ctx, n, 0);
+  bignum_assign(&d, n);
+  bignum_dec(&d);
+  s = _ctz(&d);
+  bignum_rshift(&d, &d, s);
+
+  if (_nbits(n) <= BN_PRIME_DETERMINISTIC_BITS)
+  {
+    for (i = 0; i < (int)(sizeof(bases) / sizeof(bases[0])); ++i)
+    {
+      if (!_miller_rabin(&ctx, &d, s, bases[i]))
+      {
+        return 0;
+      }
+    }
+    return 1;
+  }
+
+  return _miller_rabin(&ctx, &d, s, 2) && _strong_lucas(&ctx);
+}
+
+
+/* Strike the multiples of the sieving primes out of the window of odd candidates from s->base */
+static void _sieve_window(struct bn_sieve* s)
+{
+  uint32_t q, k;
+  int i;
+
+  for (k = 0; k < BN_PRIME_SIEVE_WINDOW / 8; ++k)
+  {
+    s->window[k] = 0;
+  }
+  for (i = 0; i < s->nprimes; ++i)
+  {
+    /* base + 2k = 0 mod q for k = -r / 2 = (q - r) * (q + 1) / 2 mod q */
+    q = s->primes[i];
+    k = ((q - s->residues[i]) * ((q + 1) / 2)) % q;
+    for (; k < BN_PRIME_SIEVE_WINDOW; k += q)
+    {
+      s->window[k / 8] |= (uint8_t)(1 << (k % 8));
+    }
+  }
+}
+
+
+/* a mod d for 0 < d < 2^(8 * (sizeof(DTYPE_TMP) - WORD_SIZE)) */
+static DTYPE_TMP _mod_small(const struct bn* a, DTYPE_TMP d)
+{
+  DTYPE_TMP rem = 0;
+  int i;
+  for (i = _nlimbs(a) - 1; i >= 0; --i)
+  {
+    rem = ((rem << (8 * WORD_SIZE)) | a->array[i]) % d;
+  }
+  return rem;
+}
+
+
+/* Strong probable-prime test of the modulus to a base below it, with modulus - 1 = d * 2^s */
+static int _miller_rabin(const struct bn_mont* ctx, const struct bn* d, int s, DTYPE base)
+{
+  struct bn x, minus_one;
+  int i;
+
+  /* -1 in Montgomery form is m - R mod m */
+  bignum_sub(&ctx->m, &ctx->one, &minus_one);
+
+  bignum_from_int(&x, base);
+  _mont_mul(&x, &x, &ctx->r2, ctx);
+  _mont_pow(&x, &x, d, ctx);
+  if ((bignum_cmp(&x, &ctx->one) == EQUAL) || (bignum_cmp(&x, &minus_one) == EQUAL))
+  {
+    return 1;
+  }
+  for (i = 1; i < s; ++i)
+  {
+    _mont_sqr(&x, &x, ctx);
+    if (bignum_cmp(&x, &minus_one) == EQUAL)
+    {
+      return 1;
+    }
+    if (bignum_cmp(&x, &ctx->one) == EQUAL)
+    {
+      return 0;
+    }
+  }
+  return 0;
+}
+
+
+/*
+  Strong Lucas probable-prime test of the modulus n, which must be odd, above 37 and
+  not divisible by 3 (so n + 1 does not wrap). With P = 1, Q = (1 - D) / 4 and the first D
+  of 5, -7, 9, -11, ... with (D/n) = -1, and n + 1 = d * 2^s: U(d) = 0, or V(d * 2^r) = 0
+  for some r < s. U and V double by U(2k) = U(k) V(k), V(2k) = V(k)^2 - 2 Q^k and step by
+  U(k+1) = (P U(k) + V(k)) / 2, V(k+1) = (D U(k) + P V(k)) / 2.
+*/
+static int _strong_lucas(const struct bn_mont* ctx)
+{
+  const int n = ctx->nlimbs;
+  struct bn d, dm, qm, u, v, qk, t;
+  int32_t D = 5;
+  int tries = 0;
+  int s, i, j;
+
+  for (;;)
+  {
+    bignum_from_int(&t, (DTYPE_TMP)((D < 0) ? -D : D));
+    j = bignum_jacobi(&t, &ctx->m);
+    if ((D < 0) && ((ctx->m.array[0] & 3) == 3))
+    {
+      j = -j; /* (-1/n) = -1 for n = 3 mod 4 */
+    }
+    if (j == -1)
+    {
+      break;
+    }
+    if (j == 0)
+    {
+      return 0; /* |D| is far below n, so n shares a factor with it */
+    }
+    /* A square never finds (D/n) = -1, check once the search drags on */
+    tries += 1;
+    if ((tries == 5) && _is_square(&ctx->m))
+    {
+      return 0;
+    }
+    D = (D > 0) ? -(D + 2) : (2 - D);
+  }
 
-  /* tmp = (c * b) */
-  bignum_mul(c, b, &tmp);
+  /* n + 1 = d * 2^s, n + 1 cannot wrap: all ones is divisible by 3 */
+  bignum_assign(&d, &ctx->m);
+  bignum_inc(&d);
+  s = _ctz(&d);
+  bignum_rshift(&d, &d, s);
 
-  /* c = a - tmp */
-  bignum_sub(a, &tmp, d);
-}
+  _lucas_const(&dm, D, ctx);
+  _lucas_const(&qm, (1 - D) / 4, ctx);
+  bignum_assign(&u, &ctx->one);
+  bignum_assign(&v, &ctx->one);
+  bignum_assign(&qk, &qm);
 
+  for (i = _nbits(&d) - 2; i >= 0; --i)
+  {
+    _mont_mul(&u, &u, &v, ctx);
+    _mont_sqr(&v, &v, ctx);
+    _mod_sub(&v, &v, &qk, &ctx->m, n);
+    _mod_sub(&v, &v, &qk, &ctx->m, n);
+    _mont_sqr(&qk, &qk, ctx);
 
-void bignum_and(const struct bn* a, const struct bn* b, struct bn* c)
-{
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
+    if ((d.array[i / (8 * WORD_SIZE)] >> (i % (8 * WORD_SIZE))) & 1)
+    {
+      _mont_mul(&t, &dm, &u, ctx);
+      _mod_add(&u, &u, &v, &ctx->m, n);
+      _mod_halve(&u, 1, &ctx->m, ctx->minv, n);
+      _mod_add(&v, &v, &t, &ctx->m, n);
+      _mod_halve(&v, 1, &ctx->m, ctx->minv, n);
+      _mont_mul(&qk, &qk, &qm, ctx);
+    }
+  }
 
-  int i;
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  if (_is_zero_limbs(&u, n) || _is_zero_limbs(&v, n))
   {
-    c->array[i] = (a->array[i] & b->array[i]);
+    return 1;
+  }
+  for (i = 1; i < s; ++i)
+  {
+    _mont_sqr(&v, &v, ctx);
+    _mod_sub(&v, &v, &qk, &ctx->m, n);
+    _mod_sub(&v, &v, &qk, &ctx->m, n);
+    if (_is_zero_limbs(&v, n))
+    {
+      return 1;
+    }
+    _mont_sqr(&qk, &qk, ctx);
   }
+  return 0;
 }
 
 
-void bignum_or(const struct bn* a, const struct bn* b, struct bn* c)
+/* x = c mod m in Montgomery form, for a small signed c */
+static void _lucas_const(struct bn* x, int32_t c, const struct bn_mont* ctx)
 {
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
+  struct bn t;
 
-  int i;
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  bignum_from_int(&t, (DTYPE_TMP)((c < 0) ? -c : c));
+  _mont_mul(&t, &t, &ctx->r2, ctx);
+  bignum_init(x);
+  if (c < 0)
   {
-    c->array[i] = (a->array[i] | b->array[i]);
+    _mod_sub(x, x, &t, &ctx->m, ctx->nlimbs);
+  }
+  else
+  {
+    bignum_assign(x, &t);
   }
 }
 
 
-void bignum_xor(const struct bn* a, const struct bn* b, struct bn* c)
+/* Newton's iteration for floor(sqrt(n)) from above, n > 0 */
+static int _is_square(const struct bn* n)
 {
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
+  struct bn x, y, t;
 
-  int i;
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  bignum_init(&x);
+  x.array[((_nbits(n) + 1) / 2) / (8 * WORD_SIZE)] |= (DTYPE)1 << (((_nbits(n) + 1) / 2) % (8 * WORD_SIZE));
+  for (;;)
   {
-    c->array[i] = (a->array[i] ^ b->array[i]);
+    bignum_div(n, &x, &t);
+    bignum_add(&x, &t, &y);
+    _rshift_one_bit(&y);
+    if (bignum_cmp(&y, &x) != SMALLER)
+    {
+      break;
+    }
+    bignum_assign(&x, &y);
   }
+  bignum_mul(&x, &x, &t);
+  return (bignum_cmp(&t, n) == EQUAL);
 }
 
 
-int bignum_cmp(const struct bn* a, const struct bn* b)
+/* Odd-only sieve of Eratosthenes: bit i of composite[] is set when 2i+1 is composite */
+static void _sieve(uint32_t n, uint8_t* composite)
 {
-  require(a, "a is null");
-  require(b, "b is null");
+  uint32_t i, j;
 
-  int i = BN_ARRAY_SIZE;
-  do
+  for (i = 0; i <= n / 16; ++i)
   {
-    i -= 1; /* Decrement first, to start with last array element */
-    if (a->array[i] > b->array[i])
-    {
-      return LARGER;
-    }
-    else if (a->array[i] < b->array[i])
+    composite[i] = 0;
+  }
+  composite[0] |= 1; /* 1 is not a prime */
+
+  for (i = 3; i * i <= n; i += 2)
+  {
+    if (!(composite[i / 16] & (1 << ((i / 2) % 8))))
     {
-      return SMALLER;
+      for (j = i * i; j <= n; j += 2 * i)
+      {
+        composite[j / 16] |= (1 << ((j / 2) % 8));
+      }
     }
   }
-  while (i != 0);
+}
 
-  return EQUAL;
+
+static int _is_odd_prime(uint32_t p, const uint8_t* composite)
+{
+  return (p & 1) && !(composite[p / 16] & (1 << ((p / 2) % 8)));
 }
 
 
-int bignum_is_zero(const struct bn* n)
+/* Exponent of the prime p in n! / (k! m!), summed over the powers of p (Legendre) */
+static uint32_t _binomial_exponent(uint32_t p, uint32_t n, uint32_t k, uint32_t m)
 {
-  require(n, "n is null");
+  uint32_t e = 0;
+  while (n >= p)
+  {
+    n /= p;
+    k /= p;
+    m /= p;
+    e += n - k - m;
+  }
+  return e;
+}
 
-  int i;
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+
+/* out = product of p^e over the odd primes lo <= p <= hi, e being the exponent of p in n! / (k! m!) */
+static void _prime_product(uint32_t lo, uint32_t hi, uint32_t n, uint32_t k, uint32_t m, const uint8_t* composite, struct bn* out)
+{
+  if (lo > hi)
   {
-    if (n->array[i])
+    bignum_from_int(out, 1);
+    return;
+  }
+  if (hi - lo < 256)
+  {
+    DTYPE_TMP acc = 1;
+    uint32_t p;
+
+    bignum_from_int(out, 1);
+    for (p = lo | 1; (p <= hi) && (p >= lo); p += 2)
     {
-      return 0;
+      if (_is_odd_prime(p, composite))
+      {
+        uint32_t e = _binomial_exponent(p, n, k, m);
+        if (e != 0)
+        {
+          /* p^e <= n, so square-and-multiply stays within 32 bits */
+          uint32_t base = p;
+          uint32_t power = 1;
+          while (1)
+          {
+            if (e & 1)
+            {
+              power *= base;
+            }
+            e >>= 1;
+            if (e == 0)
+            {
+              break;
+            }
+            base *= base;
+          }
+          _mul_factor(out, &acc, power);
+        }
+      }
     }
+    _mul_add_word(out, (DTYPE)acc, 0);
+    return;
   }
 
-  return 1;
+  struct bn right;
+  uint32_t mid = lo + (hi - lo) / 2;
+  _prime_product(lo, mid, n, k, m, composite, out);
+  _prime_product(mid + 1, hi, n, k, m, composite, &right);
+  bignum_mul(out, &right, out);
 }
 
 
-void bignum_pow(const struct bn* a, const struct bn* b, struct bn* c)
+/* Odd part of n! by the prime-swing recursion: n! = (n/2)!^2 * swing(n) */
+static void _factorial_swing(uint32_t n, const uint8_t* composite, struct bn* out)
 {
-  require(a, "a is null");
-  require(b, "b is null");
-  require(c, "c is null");
+  if (n < 3)
+  {
+    bignum_from_int(out, 1);
+    return;
+  }
 
-  struct bn tmp;
+  struct bn swing;
+  _factorial_swing(n / 2, composite, out);
+  bignum_mul(out, out, out);
+  _prime_product(3, n, n, n / 2, n / 2, composite, &swing);
+  bignum_mul(out, &swing, out);
+}
 
-  bignum_init(c);
 
-  if (bignum_cmp(b, c) == EQUAL)
+/* Number of significant limbs in a, at least one */
+static int _nlimbs(const struct bn* a)
+{
+  int i = BN_ARRAY_SIZE;
+  while ((i > 1) && (a->array[i - 1] == 0))
   {
-    /* Return 1 when exponent is 0 -- n^0 = 1 */
-    bignum_inc(c);
+    i -= 1;
   }
-  else
-  {
-    struct bn bcopy;
-    bignum_assign(&bcopy, b);
-
-    /* Copy a -> tmp */
-    bignum_assign(&tmp, a);
+  return i;
+}
 
-    bignum_dec(&bcopy);
- 
-    /* Begin summing products: */
-    while (!bignum_is_zero(&bcopy))
-    {
 
-      /* c = tmp * tmp */
-      bignum_mul(&tmp, a, c);
-      /* Decrement b by one */
-      bignum_dec(&bcopy);
+/* Number of significant bits in a, zero for a == 0 */
+static int _nbits(const struct bn* a)
+{
+  int i = _nlimbs(a) - 1;
+  int nbits = i * (8 * WORD_SIZE);
+  DTYPE top = a->array[i];
+  while (top)
+  {
+    nbits += 1;
+    top >>= 1;
+  }
+  return nbits;
+}
 
-      bignum_assign(&tmp, c);
-    }
 
-    /* c = tmp */
-    bignum_assign(c, &tmp);
+/* -m0^-1 mod 2^(8 * WORD_SIZE) for odd m0, by Newton iteration */
+static DTYPE _mont_minv(DTYPE m0)
+{
+  DTYPE inv = m0; /* correct to 3 bits, since m0 * m0 == 1 mod 8 */
+  int i;
+  for (i = 0; i < 5; ++i)
+  {
+    inv = (DTYPE)(inv * (DTYPE)(2 - (DTYPE)(m0 * inv)));
   }
+  return (DTYPE)(0 - inv);
 }
 
-void bignum_isqrt(const struct bn *a, struct bn* b)
+
+/* one = R mod m and r2 = R^2 mod m, where R = 2^(8 * WORD_SIZE * nlimbs), by repeated doubling on the low nlimbs limbs */
+static void _mont_consts(const struct bn* m, int nlimbs, struct bn* one, struct bn* r2)
 {
-  require(a, "a is null");
-  require(b, "b is null");
+  const int nbits = (8 * WORD_SIZE * nlimbs);
+  struct bn x;
+  int i;
 
-  struct bn low, high, mid, tmp;
+  bignum_from_int(&x, 1);
+  for (i = 0; i < 2 * nbits; ++i)
+  {
+    _mod_add(&x, &x, &x, m, nlimbs);
+    if (i == nbits - 1)
+    {
+      bignum_assign(one, &x);
+    }
+  }
+  bignum_assign(r2, &x);
+}
 
-  bignum_init(&low);
-  bignum_assign(&high, a);
-  bignum_rshift(&high, &mid, 1);
-  bignum_inc(&mid);
 
-  while (bignum_cmp(&high, &low) > 0) 
+/*
+  A lazy context takes R >= 4m, one limb wider than m when need be, so that products of
+  operands below 2m stay below 2m without the final subtraction. It falls back to full
+  reduction when m leaves no room at the top of the array.
+*/
+static void _mont_init(struct bn_mont* ctx, const struct bn* m, int lazy)
+{
+  bignum_assign(&ctx->m, m);
+  ctx->nlimbs = _nlimbs(m);
+  if (lazy && (m->array[ctx->nlimbs - 1] >> ((8 * WORD_SIZE) - 2)))
   {
-    bignum_mul(&mid, &mid, &tmp);
-    if (bignum_cmp(&tmp, a) > 0) 
+    if (ctx->nlimbs < BN_ARRAY_SIZE)
     {
-      bignum_assign(&high, &mid);
-      bignum_dec(&high);
+      ctx->nlimbs += 1;
     }
-    else 
+    else
     {
-      bignum_assign(&low, &mid);
+      lazy = 0;
     }
-    bignum_sub(&high,&low,&mid);
-    _rshift_one_bit(&mid);
-    bignum_add(&low,&mid,&mid);
-    bignum_inc(&mid);
   }
-  bignum_assign(b,&low);
+  ctx->lazy = lazy;
+  ctx->minv = _mont_minv(m->array[0]);
+  _mont_consts(m, ctx->nlimbs, &ctx->one, &ctx->r2);
+  bignum_lshift(m, &ctx->bound, lazy);
 }
 
 
-void bignum_assign(struct bn* dst, const struct bn* src)
+/*
+  r = a * b * R^-1 mod m, for a, b < m (below 2m, and r as well, in a lazy context), by word-serial
+  Montgomery multiplication; one lane of _mont_mul_lanes(). Only the low nlimbs limbs of r are
+  written, r may alias a or b.
+*/
+static void _mont_mul(struct bn* r, const struct bn* a, const struct bn* b, const struct bn_mont* ctx)
 {
-  require(dst, "dst is null");
-  require(src, "src is null");
+  const int nbits = (8 * WORD_SIZE);
+  const int nlimbs = ctx->nlimbs;
+  const DTYPE* m = ctx->m.array;
+  DTYPE t[BN_ARRAY_SIZE + 2];
+  DTYPE_TMP tmp;
+  DTYPE carry, u;
+  DTYPE hi = 0;
+  int i, j;
 
-  int i;
-  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  for (j = 0; j < nlimbs + 2; ++j)
   {
-    dst->array[i] = src->array[i];
+    t[j] = 0;
   }
-}
-
-
-/* Private / Static functions. */
-static void _rshift_word(struct bn* a, int nwords)
-{
-  /* Naive method: */
-  require(a, "a is null");
-  require(nwords >= 0, "no negative shifts");
 
-  int i;
-  if (nwords >= BN_ARRAY_SIZE)
+  for (i = 0; i < nlimbs; ++i)
   {
-    for (i = 0; i < BN_ARRAY_SIZE; ++i)
+    /* t += a[i] * b */
+    const DTYPE ai = a->array[i];
+    carry = 0;
+    for (j = 0; j < nlimbs; ++j)
     {
-      a->array[i] = 0;
+      tmp = (DTYPE_TMP)ai * b->array[j] + t[j] + carry;
+      t[j] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> nbits);
     }
-    return;
+    tmp = (DTYPE_TMP)t[nlimbs] + carry;
+    t[nlimbs] = (DTYPE)tmp;
+    t[nlimbs + 1] = (DTYPE)(tmp >> nbits);
+
+    /* t = (t + u * m) / 2^nbits, with u chosen so that the low limb cancels */
+    u = (DTYPE)(t[0] * ctx->minv);
+    tmp = (DTYPE_TMP)u * m[0] + t[0];
+    carry = (DTYPE)(tmp >> nbits);
+    for (j = 1; j < nlimbs; ++j)
+    {
+      tmp = (DTYPE_TMP)u * m[j] + t[j] + carry;
+      t[j - 1] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> nbits);
+    }
+    tmp = (DTYPE_TMP)t[nlimbs] + carry;
+    t[nlimbs - 1] = (DTYPE)tmp;
+    hi = t[nlimbs] = t[nlimbs + 1] + (DTYPE)(tmp >> nbits);
   }
 
-  for (i = 0; i < BN_ARRAY_SIZE - nwords; ++i)
-  {
-    a->array[i] = a->array[i + nwords];
-  }
-  for (; i < BN_ARRAY_SIZE; ++i)
-  {
-    a->array[i] = 0;
-  }
+  _mont_redc(r, t, hi, ctx, !ctx->lazy);
 }
 
 
-static void _lshift_word(struct bn* a, int nwords)
+/* r = a^2 * R^-1 mod m: the square first, each cross product once, then the reduction; as _mont_mul() */
+static void _mont_sqr(struct bn* r, const struct bn* a, const struct bn_mont* ctx)
 {
-  require(a, "a is null");
-  require(nwords >= 0, "no negative shifts");
+  const int nbits = (8 * WORD_SIZE);
+  const int nlimbs = ctx->nlimbs;
+  const DTYPE* m = ctx->m.array;
+  DTYPE t[2 * BN_ARRAY_SIZE];
+  DTYPE_TMP tmp;
+  DTYPE carry, hi, u;
+  int i, j;
 
-  int i;
-  /* Shift whole words */
-  for (i = (BN_ARRAY_SIZE - 1); i >= nwords; --i)
+  for (j = 0; j < 2 * nlimbs; ++j)
   {
-    a->array[i] = a->array[i - nwords];
+    t[j] = 0;
   }
-  /* Zero pad shifted words. */
-  for (; i >= 0; --i)
-  {
-    a->array[i] = 0;
-  }  
-}
 
+  /* t = sum of a[i] * a[j] for i < j */
+  for (i = 0; i < nlimbs - 1; ++i)
+  {
+    const DTYPE ai = a->array[i];
+    carry = 0;
+    for (j = i + 1; j < nlimbs; ++j)
+    {
+      tmp = (DTYPE_TMP)ai * a->array[j] + t[i + j] + carry;
+      t[i + j] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> nbits);
+    }
+    t[i + nlimbs] = carry;
+  }
 
-static void _lshift_one_bit(struct bn* a)
-{
-  require(a, "a is null");
+  /* t = 2t + the squares a[i]^2 on the diagonal, hi the bit shifted out of the last limb */
+  carry = 0;
+  hi = 0;
+  for (i = 0; i < nlimbs; ++i)
+  {
+    const DTYPE lo = t[2 * i];
+    const DTYPE up = t[2 * i + 1];
+    const DTYPE_TMP sq = (DTYPE_TMP)a->array[i] * a->array[i];
+    tmp = (DTYPE_TMP)(DTYPE)sq + (DTYPE)((lo << 1) | hi) + carry;
+    t[2 * i] = (DTYPE)tmp;
+    carry = (DTYPE)(tmp >> nbits);
+    tmp = (DTYPE_TMP)(DTYPE)(sq >> nbits) + (DTYPE)((up << 1) | (lo >> (nbits - 1))) + carry;
+    t[2 * i + 1] = (DTYPE)tmp;
+    carry = (DTYPE)(tmp >> nbits);
+    hi = (DTYPE)(up >> (nbits - 1));
+  }
 
-  int i;
-  for (i = (BN_ARRAY_SIZE - 1); i > 0; --i)
+  /* Reduce the low half away one limb at a time, carrying into the high half */
+  hi = 0;
+  for (i = 0; i < nlimbs; ++i)
   {
-    a->array[i] = (a->array[i] << 1) | (a->array[i - 1] >> ((8 * WORD_SIZE) - 1));
+    u = (DTYPE)(t[i] * ctx->minv);
+    carry = 0;
+    for (j = 0; j < nlimbs; ++j)
+    {
+      tmp = (DTYPE_TMP)u * m[j] + t[i + j] + carry;
+      t[i + j] = (DTYPE)tmp;
+      carry = (DTYPE)(tmp >> nbits);
+    }
+    tmp = (DTYPE_TMP)t[i + nlimbs] + carry + hi;
+    t[i + nlimbs] = (DTYPE)tmp;
+    hi = (DTYPE)(tmp >> nbits);
   }
-  a->array[0] <<= 1;
+
+  _mont_redc(r, t + nlimbs, hi, ctx, !ctx->lazy);
 }
 
 
-static void _rshift_one_bit(struct bn* a)
+/*
+  r = the nlimbs limbs of t plus hi above them, less m when that does not go negative and reduce
+  is set; branch-free. The last step of _mont_mul() and _mont_sqr().
+*/
+static void _mont_redc(struct bn* r, const DTYPE* t, DTYPE hi, const struct bn_mont* ctx, int reduce)
 {
-  require(a, "a is null");
+  const int nbits = (8 * WORD_SIZE);
+  const int nlimbs = ctx->nlimbs;
+  const DTYPE* m = ctx->m.array;
+  DTYPE d[BN_ARRAY_SIZE];
+  DTYPE_TMP tmp;
+  DTYPE borrow = 0;
+  int j;
 
-  int i;
-  for (i = 0; i < (BN_ARRAY_SIZE - 1); ++i)
+  for (j = 0; j < nlimbs; ++j)
   {
-    a->array[i] = (a->array[i] >> 1) | (a->array[i + 1] << ((8 * WORD_SIZE) - 1));
+    tmp = (DTYPE_TMP)t[j] - m[j] - borrow;
+    d[j] = (DTYPE)tmp;
+    borrow = (DTYPE)((tmp >> nbits) & 1);
+  }
+  const DTYPE keep = (DTYPE)0 - (DTYPE)((borrow > hi) | !reduce);
+  for (j = 0; j < nlimbs; ++j)
+  {
+    r->array[j] = (t[j] & keep) | (d[j] & ~keep);
   }
-  a->array[BN_ARRAY_SIZE - 1] >>= 1;
 }
 
-/* O(log n) */
-void bignum_pow_mod(const struct bn* a, const struct bn* b, const struct bn* n, struct bn* res)
-{
-  require(a, "a is null");
-  require(b, "b is null");
-  require(n, "n is null");
-  require(res, "res is null");
-
-  bignum_from_int(res, 1); /* r = 1 */
 
-  struct bn tmpa;
-  struct bn tmpb;
-  struct bn tmp;
-  bignum_assign(&tmpa, a);
-  bignum_assign(&tmpb, b);
+/* r = a^e in Montgomery form, by left-to-right square-and-multiply */
+static void _mont_pow(struct bn* r, const struct bn* a, const struct bn* e, const struct bn_mont* ctx)
+{
+  struct bn acc, base;
+  int i;
 
-  while (1)
+  bignum_assign(&base, a);
+  bignum_assign(&acc, &ctx->one);
+  for (i = _nbits(e) - 1; i >= 0; --i)
   {
-    if (tmpb.array[0] & 1) /* if (b % 2) */
+    _mont_sqr(&acc, &acc, ctx);
+    if ((e->array[i / (8 * WORD_SIZE)] >> (i % (8 * WORD_SIZE))) & 1)
     {
-      bignum_mul(res, &tmpa, &tmp); /* r = r * a % m */
-      bignum_mod(&tmp, n, res);
+      _mont_mul(&acc, &acc, &base, ctx);
     }
-    bignum_rshift(&tmpb, &tmp, 1); /* b /= 2 */
-    bignum_assign(&tmpb, &tmp);
-
-    if (bignum_is_zero(&tmpb))
-      break;
-
-    bignum_mul(&tmpa, &tmpa, &tmp);
-    bignum_mod(&tmp, n, &tmpa);
   }
+  bignum_assign(r, &acc);
 }
-
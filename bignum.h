@@ -45,6 +45,7 @@ There may well be room for performance-optimizations and improvements.
 
 */
 
+#include <stddef.h>
 #include <stdint.h>
 #include <assert.h>
 
@@ -62,6 +63,56 @@ extern "C" {
   #define BN_ARRAY_SIZE (256 / WORD_SIZE)
 #endif
 
+/* Largest n sieved for primes by bignum_factorial_swing() and bignum_binomial(): C(n, k) always fits below it */
+#ifndef BN_SIEVE_LIMIT
+  #define BN_SIEVE_LIMIT (BN_ARRAY_SIZE * WORD_SIZE * 8)
+#endif
+
+/* Decimal conversion works on blocks of this many limb-sized chunks of digits, splitting larger numbers by powers of ten */
+#ifndef BN_DECIMAL_LEAF_CHUNKS
+  #define BN_DECIMAL_LEAF_CHUNKS 32
+#endif
+
+/* bignum_gcd() switches from Lehmer's algorithm to the binary one below this many bits */
+#ifndef BN_GCD_LEHMER_THRESHOLD
+  #define BN_GCD_LEHMER_THRESHOLD 512
+#endif
+
+/* bignum_is_probable_prime() divides by the primes below this before any exponentiation; below 2^16 */
+#ifndef BN_PRIME_TRIAL_LIMIT
+  #define BN_PRIME_TRIAL_LIMIT 1000
+#endif
+
+/* bignum_next_prime() strikes the multiples of the odd primes below this out of its candidates; below 2^16 */
+#ifndef BN_PRIME_SIEVE_LIMIT
+  #define BN_PRIME_SIEVE_LIMIT 8192
+#endif
+
+/* ... for this many consecutive odd candidates at a time, a multiple of 8 */
+#ifndef BN_PRIME_SIEVE_WINDOW
+  #define BN_PRIME_SIEVE_WINDOW 2048
+#endif
+
+/* Up to this many bits Miller-Rabin to the prime bases 2 .. 37 is exact: no strong pseudoprime to all is that small */
+#ifndef BN_PRIME_DETERMINISTIC_BITS
+  #define BN_PRIME_DETERMINISTIC_BITS 78
+#endif
+
+/* Montgomery contexts of this many recent odd moduli are kept for bignum_pow_mod(); 0 turns the cache off.
+   It relies on the GCC / Clang __atomic builtins, so other compilers get no cache by default. */
+#ifndef BN_MODCACHE_SIZE
+  #if defined(__GNUC__)
+    #define BN_MODCACHE_SIZE 16
+  #else
+    #define BN_MODCACHE_SIZE 0
+  #endif
+#endif
+
+/* Characters bignum_write_decimal() collects on the stack before each call of the writer */
+#ifndef BN_WRITE_BUFSIZE
+  #define BN_WRITE_BUFSIZE 512
+#endif
+
 
 /* Here comes the compile-time specialization for how large the underlying array size should be. */
 /* The choices are 1, 2 and 4 bytes in size with uint32, uint64 for WORD_SIZE==4, as temporary. */
@@ -110,12 +161,63 @@ struct bn {
 /* Tokens returned by bignum_cmp() for value comparison */
 enum { SMALLER = -1, EQUAL = 0, LARGER = 1 };
 
+/* Status codes returned by the parsing functions, and BN_IO_ERROR for failed reads and writes */
+enum { BN_OK = 0, BN_INVALID = -1, BN_OVERFLOW = -2, BN_IO_ERROR = -3 };
+
+/* Incremental prime sieve, see bignum_sieve_init() */
+struct bn_sieve {
+  struct bn base;                               /* first odd candidate of the window, or the last prime returned while small */
+  uint16_t primes[BN_PRIME_SIEVE_LIMIT / 2];    /* the odd sieving primes */
+  uint16_t residues[BN_PRIME_SIEVE_LIMIT / 2];  /* base mod primes[i] */
+  uint8_t window[BN_PRIME_SIEVE_WINDOW / 8];    /* bit k set: base + 2k has a small factor */
+  uint32_t next;                                /* next k to hand out */
+  int nprimes;
+  int small;                                    /* started below BN_PRIME_SIEVE_LIMIT: hands out the primes themselves */
+  int status;                                   /* BN_OVERFLOW once past the largest number */
+};
+
+/* Montgomery context of an odd modulus m > 1, see bignum_mont_init() */
+struct bn_mont {
+  struct bn m;
+  struct bn one;    /* R mod m, i.e. 1 in Montgomery form */
+  struct bn r2;     /* R^2 mod m, converts into Montgomery form */
+  struct bn bound;  /* 2m when lazy, else m: values in Montgomery form stay below it */
+  DTYPE minv;       /* -m^-1 mod 2^(8 * WORD_SIZE) */
+  int nlimbs;       /* R = 2^(8 * WORD_SIZE * nlimbs) */
+  int lazy;         /* R >= 4m: products skip the final subtraction */
+};
+
+/* Output callback of bignum_write_decimal(): returns BN_OK, or a negative status to stop */
+typedef int (*bn_write_fn)(void* ctx, const char* text, int len);
+
+/* Random source of bignum_gen_prime(): fills buf with len random bytes, returns BN_OK or a negative status to stop */
+typedef int (*bn_random_fn)(void* ctx, uint8_t* buf, size_t len);
+
 /* Initialization functions: */
 void bignum_init(struct bn* n);
 void bignum_from_int(struct bn* n, DTYPE_TMP i);
 int  bignum_to_int(struct bn* n);
-void bignum_from_string(struct bn* n, const char* str, int nbytes);
-void bignum_to_string(const struct bn* n, char* str, int maxsize);
+int  bignum_from_string(struct bn* n, const char* str, int nbytes);   /* Hex, optional 0x: returns BN_OK, BN_INVALID or BN_OVERFLOW */
+int  bignum_to_string(const struct bn* n, char* str, int maxsize);    /* Hex: returns the number of digits, like snprintf() */
+int  bignum_to_decimal(const struct bn* n, char* str, int maxsize);   /* Returns the number of digits, like snprintf() */
+int  bignum_from_decimal(struct bn* n, const char* str, size_t len);  /* Returns BN_OK, BN_INVALID or BN_OVERFLOW */
+int  bignum_write_decimal(const struct bn* n, bn_write_fn write, void* ctx);  /* Streams the digits in blocks: returns their number or the writer's error */
+
+/* Other bases, returning the length like snprintf() or BN_OK, BN_INVALID or BN_OVERFLOW: */
+int  bignum_to_radix(const struct bn* n, char* str, int maxsize, int base);   /* Base 2 to 64, digits 0-9a-zA-Z+/ */
+int  bignum_from_radix(struct bn* n, const char* str, size_t len, int base);  /* Case-insensitive up to base 36 */
+int  bignum_to_base58(const struct bn* n, char* str, int maxsize);            /* Bitcoin alphabet */
+int  bignum_from_base58(struct bn* n, const char* str, size_t len);
+int  bignum_to_base64(const struct bn* n, char* str, int maxsize);            /* RFC 4648 of the big-endian bytes, padded */
+int  bignum_from_base64(struct bn* n, const char* str, size_t len);           /* Padding optional */
+
+/* Unsigned binary import / export, e.g. RSA keys and signatures: */
+int  bignum_nbytes(const struct bn* n);                                 /* Bytes needed to hold n, 0 for zero */
+int  bignum_nbits(const struct bn* n);                                  /* Bits needed to hold n, 0 for zero */
+int  bignum_from_bytes_be(struct bn* n, const uint8_t* buf, size_t len); /* Returns BN_OK or BN_OVERFLOW */
+int  bignum_from_bytes_le(struct bn* n, const uint8_t* buf, size_t len); /* Returns BN_OK or BN_OVERFLOW */
+int  bignum_to_bytes_be(const struct bn* n, uint8_t* buf, size_t len);  /* Exactly len bytes, zero-padded: BN_OK or BN_OVERFLOW */
+int  bignum_to_bytes_le(const struct bn* n, uint8_t* buf, size_t len);  /* Exactly len bytes, zero-padded: BN_OK or BN_OVERFLOW */
 
 /* Basic arithmetic operations: */
 void bignum_add(const struct bn* a, const struct bn* b, struct bn* c); /* c = a + b */
@@ -141,8 +243,54 @@ void bignum_pow(const struct bn* a, const struct bn* b, struct bn* c); /* Calcul
 void bignum_isqrt(const struct bn* a, struct bn* b);             /* Integer square root -- e.g. isqrt(5) => 2*/
 void bignum_assign(struct bn* dst, const struct bn* src);  /* Copy src into dst -- dst := src */
 
-/* Faster power and module sequence of operations, for RSA: O(log n) */
+/* Products by binary splitting, so that the multiplications are balanced */
+void bignum_product_range(uint32_t lo, uint32_t hi, struct bn* out); /* out = lo * (lo+1) * ... * hi, 1 if lo > hi */
+void bignum_factorial(uint32_t n, struct bn* out);                   /* out = n! */
+
+/* Factorials and binomials from the prime factorization of the swing numbers */
+void bignum_factorial_swing(uint32_t n, struct bn* out);             /* out = n! */
+void bignum_binomial(uint32_t n, uint32_t k, struct bn* out);        /* out = n! / (k! * (n-k)!), which must fit: out is unspecified otherwise */
+
+/* Faster power and module sequence of operations, for RSA: O(log n), by Montgomery multiplication for odd n */
 void bignum_pow_mod(const struct bn* a, const struct bn* b, const struct bn* n, struct bn* res);
+void bignum_pow_mod_word(const struct bn* a, DTYPE_TMP e, const struct bn* n, struct bn* res); /* res = a^e mod n for a one-word e, e.g. RSA verification */
+
+/* The cache of moduli behind bignum_pow_mod(), see BN_MODCACHE_SIZE; safe to use from any thread */
+void bignum_modcache_stats(unsigned long* hits, unsigned long* misses); /* Lookups since the last clear that found / missed their modulus */
+void bignum_modcache_clear(void);                                      /* Drop every entry and zero the counters */
+
+/* Modular arithmetic on operands already below m: one carry pass and a branch-free correction, no division */
+void bignum_mod_add(const struct bn* a, const struct bn* b, const struct bn* m, struct bn* c); /* c = (a + b) mod m */
+void bignum_mod_sub(const struct bn* a, const struct bn* b, const struct bn* m, struct bn* c); /* c = (a - b) mod m */
+void bignum_mod_neg(const struct bn* a, const struct bn* m, struct bn* c);                     /* c = -a mod m */
+void bignum_mod_dbl(const struct bn* a, const struct bn* m, struct bn* c);                     /* c = 2a mod m */
+
+/* Montgomery form, for long chains of modular arithmetic by one odd modulus: convert only at the ends */
+int  bignum_mont_init(struct bn_mont* ctx, const struct bn* m);                                  /* BN_OK, or BN_INVALID unless m is odd and > 1 */
+void bignum_to_mont(const struct bn* a, const struct bn_mont* ctx, struct bn* x);                 /* x = a * R mod m */
+void bignum_from_mont(const struct bn* x, const struct bn_mont* ctx, struct bn* a);               /* a = x * R^-1 mod m, fully reduced */
+void bignum_mont_mul(const struct bn* x, const struct bn* y, const struct bn_mont* ctx, struct bn* z); /* z = x * y * R^-1, below 2m */
+void bignum_mont_sqr(const struct bn* x, const struct bn_mont* ctx, struct bn* z);                /* z = x * x * R^-1, below 2m */
+void bignum_mont_add(const struct bn* x, const struct bn* y, const struct bn_mont* ctx, struct bn* z); /* z = x + y, below 2m */
+void bignum_mont_sub(const struct bn* x, const struct bn* y, const struct bn_mont* ctx, struct bn* z); /* z = x - y, below 2m */
+
+/* Independent exponentiations interleaved across lanes: res[i] = a[i]^b[i] mod n[i] */
+void bignum_pow_mod_x4(const struct bn a[4], const struct bn b[4], const struct bn n[4], struct bn res[4]);
+void bignum_pow_mod_x8(const struct bn a[8], const struct bn b[8], const struct bn n[8], struct bn res[8]);
+
+/* Greatest common divisor and modular inverse, by Lehmer and binary (Stein) reduction */
+void bignum_gcd(const struct bn* a, const struct bn* b, struct bn* g);                              /* g = gcd(a, b), gcd(0, 0) = 0 */
+void bignum_gcdext(const struct bn* a, const struct bn* b, struct bn* g, struct bn* x, struct bn* y); /* g = a*x - b*y, 1 <= x <= max(b/g, 1), y < a/g; x = y = 0 for a = 0 */
+int  bignum_modinv(const struct bn* a, const struct bn* m, struct bn* inv);                         /* inv = a^-1 mod m: BN_OK, or BN_INVALID if gcd(a, m) != 1 */
+int  bignum_modinv_batch(const struct bn* in, struct bn* out, size_t count, const struct bn* m);  /* out[i] = in[i]^-1 mod m with one inversion, in[i] < m of at most half the width: BN_INVALID if any has none */
+
+/* Primality: trial division, then Baillie-PSW (Miller-Rabin to base 2 and a strong Lucas test), exact below 2^78 */
+int  bignum_is_probable_prime(const struct bn* n);         /* 1 for a (probable) prime, 0 for a composite */
+int  bignum_jacobi(const struct bn* a, const struct bn* n); /* Jacobi symbol (a/n) for odd n: -1, 0 or 1 */
+int  bignum_next_prime(const struct bn* a, struct bn* p);  /* p = the first (probable) prime above a: BN_OK or BN_OVERFLOW */
+void bignum_sieve_init(struct bn_sieve* s, const struct bn* a); /* Candidates above a without a factor below BN_PRIME_SIEVE_LIMIT ... */
+int  bignum_sieve_next(struct bn_sieve* s, struct bn* c);        /* ... in increasing order: BN_OK or BN_OVERFLOW */
+int  bignum_gen_prime(struct bn* p, int nbits, bn_random_fn rng, void* ctx); /* Random prime of exactly nbits bits, top two set: BN_OK, BN_INVALID or rng's error */
 
 #ifdef __cplusplus
 }
@@ -32,7 +32,8 @@ cdef class _BigNum:
 	def fromInt(self, bignum.DTYPE_TMP num):
 		bignum.bignum_from_int(self.data, num)
 	def fromBytes(self, bytes data):
-		bignum.bignum_from_string(self.data, <const char *>data, len(data))
+		if bignum.bignum_from_string(self.data, <const char *>data, len(data)) != bignum.BN_OK:
+			raise ValueError("not a hex number that fits: %r" % data)
 	def fromBignum(self, _BigNum data):
 		bignum.bignum_assign(self.data, data.data)
 	def toBytes(self):
@@ -255,9 +256,7 @@ class BigNum(_BigNum):
 		if data is None:
 			pass
 		elif isinstance(data, str):
-			tmp = "0x" + data.lstrip('0')
-			if len(data) % 8 != 0:
-				data = "00000000"[:8 - (len(data) % 8)] + data
+			tmp = "0x" + (data.lstrip('0') or '0')
 			self.fromBytes(data.encode('utf8'))
 			assert(tmp.lower() == str(self).lower())
 		elif isinstance(data, numbers.Number):
@@ -15,15 +15,49 @@ cdef extern from "bignum.h" nogil:
 		EQUAL
 		LARGER = 1
 
+	cdef enum:
+		BN_OK = 0
+		BN_INVALID = -1
+		BN_OVERFLOW = -2
+		BN_IO_ERROR = -3
+
+	ctypedef int (*bn_write_fn)(void* ctx, const char* text, int len)
+	ctypedef int (*bn_random_fn)(void* ctx, uint8_t* buf, size_t len)
+
 	cdef struct bn:
 		DTYPE array[BN_ARRAY_SIZE]
 
+	cdef struct bn_sieve:
+		bn base
+		int small
+		int status
+
+	cdef struct bn_mont:
+		bn m
+		int nlimbs
+		int lazy
+
 	# Initialization functions
 	void bignum_init(bn* n)
 	void bignum_from_int(bn* n, DTYPE_TMP i)
 	int  bignum_to_int(bn* n)
-	void bignum_from_string(bn* n, const char* str, int nbytes)
-	void bignum_to_string(const bn* n, char* str, int maxsize)
+	int  bignum_from_string(bn* n, const char* str, int nbytes)
+	int  bignum_to_string(const bn* n, char* str, int maxsize)
+	int  bignum_to_decimal(const bn* n, char* str, int maxsize)
+	int  bignum_from_decimal(bn* n, const char* str, size_t len)
+	int  bignum_write_decimal(const bn* n, bn_write_fn write, void* ctx)
+	int  bignum_to_radix(const bn* n, char* str, int maxsize, int base)
+	int  bignum_from_radix(bn* n, const char* str, size_t len, int base)
+	int  bignum_to_base58(const bn* n, char* str, int maxsize)
+	int  bignum_from_base58(bn* n, const char* str, size_t len)
+	int  bignum_to_base64(const bn* n, char* str, int maxsize)
+	int  bignum_from_base64(bn* n, const char* str, size_t len)
+	int  bignum_nbytes(const bn* n)
+	int  bignum_nbits(const bn* n)
+	int  bignum_from_bytes_be(bn* n, const uint8_t* buf, size_t len)
+	int  bignum_from_bytes_le(bn* n, const uint8_t* buf, size_t len)
+	int  bignum_to_bytes_be(const bn* n, uint8_t* buf, size_t len)
+	int  bignum_to_bytes_le(const bn* n, uint8_t* buf, size_t len)
 
 	# Basic arithmetic operations
 	void bignum_add(const bn* a, const bn* b, bn* c)
@@ -49,5 +83,37 @@ cdef extern from "bignum.h" nogil:
 	void bignum_isqrt(const bn* a, bn* b)
 	void bignum_assign(bn* dst, const bn* src)
 
+	# Products by binary splitting
+	void bignum_product_range(uint32_t lo, uint32_t hi, bn* out)
+	void bignum_factorial(uint32_t n, bn* out)
+	void bignum_factorial_swing(uint32_t n, bn* out)
+	void bignum_binomial(uint32_t n, uint32_t k, bn* out)
+
 	# Power and Module operation
 	void bignum_pow_mod(const bn* a, const bn* b, const bn* n, bn* res)
+	void bignum_pow_mod_word(const bn* a, DTYPE_TMP e, const bn* n, bn* res)
+	void bignum_mod_add(const bn* a, const bn* b, const bn* m, bn* c)
+	void bignum_mod_sub(const bn* a, const bn* b, const bn* m, bn* c)
+	void bignum_mod_neg(const bn* a, const bn* m, bn* c)
+	void bignum_mod_dbl(const bn* a, const bn* m, bn* c)
+	void bignum_modcache_stats(unsigned long* hits, unsigned long* misses)
+	void bignum_modcache_clear()
+	int  bignum_mont_init(bn_mont* ctx, const bn* m)
+	void bignum_to_mont(const bn* a, const bn_mont* ctx, bn* x)
+	void bignum_from_mont(const bn* x, const bn_mont* ctx, bn* a)
+	void bignum_mont_mul(const bn* x, const bn* y, const bn_mont* ctx, bn* z)
+	void bignum_mont_sqr(const bn* x, const bn_mont* ctx, bn* z)
+	void bignum_mont_add(const bn* x, const bn* y, const bn_mont* ctx, bn* z)
+	void bignum_mont_sub(const bn* x, const bn* y, const bn_mont* ctx, bn* z)
+	void bignum_pow_mod_x4(const bn* a, const bn* b, const bn* n, bn* res)
+	void bignum_pow_mod_x8(const bn* a, const bn* b, const bn* n, bn* res)
+	void bignum_gcd(const bn* a, const bn* b, bn* g)
+	void bignum_gcdext(const bn* a, const bn* b, bn* g, bn* x, bn* y)
+	int  bignum_modinv(const bn* a, const bn* m, bn* inv)
+	int  bignum_modinv_batch(const bn* in, bn* out, size_t count, const bn* m)
+	int  bignum_is_probable_prime(const bn* n)
+	int  bignum_jacobi(const bn* a, const bn* n)
+	int  bignum_next_prime(const bn* a, bn* p)
+	int  bignum_gen_prime(bn* p, int nbits, bn_random_fn rng, void* ctx)
+	void bignum_sieve_init(bn_sieve* s, const bn* a)
+	int  bignum_sieve_next(bn_sieve* s, bn* c)
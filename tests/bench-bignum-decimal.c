@@ -0,0 +1,175 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+    Decimal conversion throughput
+    =============================
+
+    Converts random full-width numbers to and from decimal, with
+    bignum_to_decimal() / bignum_from_decimal() and with the obvious
+    one-digit-at-a-time loops (divide by ten, multiply by ten and add),
+    and reports digits per second for each.
+
+    The divide-and-conquer split only kicks in above a few hundred digits;
+    build with e.g. `make clean bench DEFS=-DBN_ARRAY_SIZE=2048` to see it.
+
+    Usage: bench-bignum-decimal [repetitions]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint32_t rng_state = 0x9e3779b9;
+
+static uint32_t xorshift32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Enough for the largest value, with log10(2) < 0.302 */
+#define MAX_DIGITS ((BN_ARRAY_SIZE * WORD_SIZE * 8) * 302 / 1000 + 2)
+
+static struct bn a, res;
+static char digits[MAX_DIGITS];
+static char naive_digits[MAX_DIGITS];
+
+static int naive_to_decimal(const struct bn* n, char* str)
+{
+  struct bn q, r, ten;
+  int len = 0;
+  int i;
+
+  bignum_from_int(&ten, 10);
+  bignum_assign(&q, n);
+  do
+  {
+    bignum_divmod(&q, &ten, &q, &r);
+    str[len++] = (char)('0' + bignum_to_int(&r));
+  } while (!bignum_is_zero(&q));
+
+  for (i = 0; i < len / 2; ++i)
+  {
+    char c = str[i];
+    str[i] = str[len - 1 - i];
+    str[len - 1 - i] = c;
+  }
+  str[len] = 0;
+  return len;
+}
+
+static void naive_from_decimal(struct bn* n, const char* str, int len)
+{
+  struct bn ten, digit;
+  int i;
+
+  bignum_from_int(&ten, 10);
+  bignum_init(n);
+  for (i = 0; i < len; ++i)
+  {
+    bignum_mul(n, &ten, n);
+    bignum_from_int(&digit, str[i] - '0');
+    bignum_add(n, &digit, n);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  int reps = (argc > 1) ? atoi(argv[1]) : 20;
+  int i, len = 0;
+
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    a.array[i] = (DTYPE)xorshift32();
+  }
+
+  printf("%d repetitions, %d-bit numbers\n", reps, BN_ARRAY_SIZE * WORD_SIZE * 8);
+
+  double start = now();
+  for (i = 0; i < reps; ++i)
+  {
+    naive_to_decimal(&a, naive_digits);
+  }
+  double naive_out = now() - start;
+
+  start = now();
+  for (i = 0; i < reps; ++i)
+  {
+    len = bignum_to_decimal(&a, digits, sizeof(digits));
+  }
+  double out = now() - start;
+
+  if (strcmp(digits, naive_digits) != 0)
+  {
+    printf("decimal output differs\n");
+    return 1;
+  }
+
+  start = now();
+  for (i = 0; i < reps; ++i)
+  {
+    naive_from_decimal(&res, digits, len);
+  }
+  double naive_in = now() - start;
+
+  start = now();
+  for (i = 0; i < reps; ++i)
+  {
+    if (bignum_from_decimal(&res, digits, len) != BN_OK)
+    {
+      printf("bignum_from_decimal failed\n");
+      return 1;
+    }
+  }
+  double in = now() - start;
+
+  if (bignum_cmp(&res, &a) != EQUAL)
+  {
+    printf("decimal input differs\n");
+    return 1;
+  }
+
+  printf("%d digits\n", len);
+  printf("digit at a time out %12.0f digits/s\n", reps * len / naive_out);
+  printf("bignum_to_decimal   %12.0f digits/s  (%.2fx)\n", reps * len / out, naive_out / out);
+  printf("digit at a time in  %12.0f digits/s\n", reps * len / naive_in);
+  printf("bignum_from_decimal %12.0f digits/s  (%.2fx)\n", reps * len / in, naive_in / in);
+
+  return 0;
+}
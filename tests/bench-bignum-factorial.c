@@ -0,0 +1,151 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+/*
+    Factorial and binomial benchmark
+    ================================
+
+    Compares the ways of computing n! for the largest n whose factorial
+    fits in a struct bn:
+      - the naive running product of tests/test-bignum-factorial.c,
+      - the balanced product tree, bignum_factorial(),
+      - the prime-swing algorithm, bignum_factorial_swing(),
+    and C(n, n/2) by bignum_binomial() against n! / ((n/2)! (n - n/2)!).
+
+    Larger builds show the difference best, e.g.
+    `make clean bench DEFS=-DBN_ARRAY_SIZE=2048`.
+
+    Usage: bench-bignum-factorial [repetitions]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* As in tests/test-bignum-factorial.c: multiply the accumulator by n, n-1, ... 2 */
+static void naive_factorial(uint32_t n, struct bn* res)
+{
+  struct bn k;
+  bignum_from_int(res, 1);
+  while (n > 1)
+  {
+    bignum_from_int(&k, n);
+    bignum_mul(res, &k, res);
+    n -= 1;
+  }
+}
+
+static struct bn results[4];
+
+int main(int argc, char** argv)
+{
+  int reps = (argc > 1) ? atoi(argv[1]) : 20;
+  int i;
+
+  /* Largest n with log2(n!) below the width of a struct bn */
+  uint32_t n = 1;
+  double bits = 0;
+  while (bits + log2(n + 1) < BN_ARRAY_SIZE * WORD_SIZE * 8)
+  {
+    n += 1;
+    bits += log2(n);
+  }
+
+  printf("%d repetitions of %u!, %d-bit numbers\n", reps, n, BN_ARRAY_SIZE * WORD_SIZE * 8);
+
+  double start = now();
+  for (i = 0; i < reps; ++i)
+  {
+    naive_factorial(n, &results[0]);
+  }
+  double naive = now() - start;
+
+  start = now();
+  for (i = 0; i < reps; ++i)
+  {
+    bignum_factorial(n, &results[1]);
+  }
+  double tree = now() - start;
+
+  start = now();
+  for (i = 0; i < reps; ++i)
+  {
+    bignum_factorial_swing(n, &results[2]);
+  }
+  double swing = now() - start;
+
+  if ((bignum_cmp(&results[0], &results[1]) != EQUAL) || (bignum_cmp(&results[0], &results[2]) != EQUAL))
+  {
+    printf("factorial results differ\n");
+    return 1;
+  }
+
+  printf("naive loop       %10.6f s/op\n", naive / reps);
+  printf("product tree     %10.6f s/op  (%.2fx)\n", tree / reps, naive / tree);
+  printf("prime swing      %10.6f s/op  (%.2fx)\n", swing / reps, naive / swing);
+
+  start = now();
+  for (i = 0; i < reps; ++i)
+  {
+    struct bn denom;
+    bignum_factorial(n / 2, &results[0]);
+    bignum_factorial(n - n / 2, &denom);
+    bignum_mul(&results[0], &denom, &denom);
+    bignum_factorial(n, &results[0]);
+    bignum_div(&results[0], &denom, &results[0]);
+  }
+  double quotient = now() - start;
+
+  start = now();
+  for (i = 0; i < reps; ++i)
+  {
+    bignum_binomial(n, n / 2, &results[3]);
+  }
+  double binomial = now() - start;
+
+  if (bignum_cmp(&results[0], &results[3]) != EQUAL)
+  {
+    printf("binomial results differ\n");
+    return 1;
+  }
+
+  printf("C(%u, %u):\n", n, n / 2);
+  printf("factorial quotient %8.6f s/op\n", quotient / reps);
+  printf("bignum_binomial  %10.6f s/op  (%.2fx)\n", binomial / reps, quotient / binomial);
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+    GCD and modular inverse throughput
+    ==================================
+
+    Times bignum_gcd(), bignum_modinv() with an odd and with an even
+    modulus, bignum_modinv_batch() per element of a batch of BATCH, and the
+    Fermat inverse a^(m-2) mod m by bignum_pow_mod() that
+    the inverse replaces, for operands of 256 to 4096 bits. Sizes that do
+    not fit the build are skipped; the batch and Fermat columns need twice
+    the width.
+    Build with e.g. `make clean bench DEFS=-DBN_ARRAY_SIZE=256` for 8192-bit
+    numbers to get every row, and compare gcd/s against a build with
+    DEFS="-DBN_ARRAY_SIZE=256 -DBN_GCD_LEHMER_THRESHOLD=100000" to see what
+    Lehmer's algorithm buys over the binary one alone.
+
+    Usage: bench-bignum-gcd [repetitions]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BATCH 64
+
+static uint32_t rng_state = 0x9e3779b9;
+
+static uint32_t xorshift32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Random number of exactly nbits bits */
+static void random_bn(struct bn* n, int nbits)
+{
+  int i;
+  bignum_init(n);
+  for (i = 0; i < nbits; ++i)
+  {
+    if ((i == nbits - 1) || (xorshift32() & 1))
+    {
+      n->array[i / (8 * WORD_SIZE)] |= (DTYPE)1 << (i % (8 * WORD_SIZE));
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const int width = BN_ARRAY_SIZE * WORD_SIZE * 8;
+  int reps = (argc > 1) ? atoi(argv[1]) : 50;
+  static struct bn batch_in[BATCH], batch_out[BATCH];
+  struct bn a, m, m_even, e, g, res;
+  int nbits, i;
+
+  printf("%d repetitions, %d-bit numbers\n", reps, width);
+  printf("%6s %12s %12s %12s %12s %12s\n", "bits", "gcd/s", "inv odd/s", "inv even/s", "batch/s", "fermat/s");
+
+  for (nbits = 256; nbits <= 4096; nbits *= 2)
+  {
+    if (nbits > width)
+    {
+      break;
+    }
+
+    /* a coprime to both moduli */
+    random_bn(&m, nbits);
+    m.array[0] |= 1;
+    bignum_assign(&m_even, &m);
+    bignum_dec(&m_even);
+    do
+    {
+      random_bn(&a, nbits - 1);
+      a.array[0] |= 1;
+    } while ((bignum_modinv(&a, &m, &res) != BN_OK) || (bignum_modinv(&a, &m_even, &res) != BN_OK));
+
+    double start = now();
+    for (i = 0; i < reps; ++i)
+    {
+      bignum_gcd(&a, &m, &g);
+    }
+    const double gcd_time = now() - start;
+
+    start = now();
+    for (i = 0; i < reps; ++i)
+    {
+      bignum_modinv(&a, &m, &res);
+    }
+    const double odd_time = now() - start;
+
+    start = now();
+    for (i = 0; i < reps; ++i)
+    {
+      bignum_modinv(&a, &m_even, &res);
+    }
+    const double even_time = now() - start;
+
+    printf("%6d %12.0f %12.0f %12.0f", nbits, reps / gcd_time, reps / odd_time, reps / even_time);
+
+    if (2 * nbits <= width)
+    {
+      /* Powers of a are all coprime to m */
+      bignum_assign(&batch_in[0], &a);
+      for (i = 1; i < BATCH; ++i)
+      {
+        bignum_mul(&batch_in[i - 1], &a, &res);
+        bignum_mod(&res, &m, &batch_in[i]);
+      }
+      const int batch_reps = (reps + BATCH - 1) / BATCH;
+      start = now();
+      for (i = 0; i < batch_reps; ++i)
+      {
+        bignum_modinv_batch(batch_in, batch_out, BATCH, &m);
+      }
+      printf(" %12.0f", batch_reps * BATCH / (now() - start));
+
+      /* Timing only: m is not prime, but the exponentiation costs the same */
+      bignum_assign(&e, &m);
+      bignum_dec(&e);
+      bignum_dec(&e);
+      const int fermat_reps = (reps + 9) / 10;
+      start = now();
+      for (i = 0; i < fermat_reps; ++i)
+      {
+        bignum_pow_mod(&a, &e, &m, &res);
+      }
+      printf(" %12.0f", fermat_reps / (now() - start));
+    }
+    else
+    {
+      printf(" %12s %12s", "-", "-");
+    }
+    printf("\n");
+  }
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+/*
+    Speedup of bignum_mul_parallel() versus the number of threads
+    =============================================================
+
+    Multiplies two random full-width numbers with pools of 1, 2, ... N
+    threads, checks that every result is identical to bignum_mul() and
+    reports the speedup relative to one thread.
+
+    The default BN_ARRAY_SIZE is too small for threads to pay off, build
+    with e.g. `make clean bench DEFS=-DBN_ARRAY_SIZE=32768` (a million bits
+    with 32-bit words) to see the intended use.
+
+    Usage: bench-bignum-mul [max-threads] [repetitions]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+#include "../bignum-thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint32_t rng_state = 0x9e3779b9;
+
+static uint32_t xorshift32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Operands are large, keep them off the stack */
+static struct bn a, b, expected, res;
+
+int main(int argc, char** argv)
+{
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  int max_threads = (argc > 1) ? atoi(argv[1]) : (int)ncpu;
+  int reps = (argc > 2) ? atoi(argv[2]) : 20;
+  int i, t;
+
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    a.array[i] = (DTYPE)xorshift32();
+    b.array[i] = (DTYPE)xorshift32();
+  }
+  bignum_mul(&a, &b, &expected);
+
+  printf("%d x bignum_mul_parallel, %d-bit operands, %ld online CPUs\n", reps, BN_ARRAY_SIZE * WORD_SIZE * 8, ncpu);
+  printf("threads    seconds   speedup\n");
+
+  double base = 0;
+  for (t = 1; t <= max_threads; ++t)
+  {
+    struct bn_pool pool;
+    bn_pool_init(&pool, t);
+    pool.mul_threshold = 1;
+
+    double start = now();
+    for (i = 0; i < reps; ++i)
+    {
+      bignum_mul_parallel(&pool, &a, &b, &res);
+    }
+    double elapsed = now() - start;
+
+    bn_pool_destroy(&pool);
+
+    if (bignum_cmp(&res, &expected) != EQUAL)
+    {
+      printf("result with %d threads differs from bignum_mul()\n", t);
+      return 1;
+    }
+    if (t == 1)
+    {
+      base = elapsed;
+    }
+    printf("%7d %10.3f %9.2f\n", t, elapsed, base / elapsed);
+  }
+
+  return 0;
+}
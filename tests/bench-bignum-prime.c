@@ -0,0 +1,137 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+    Prime search throughput
+    =======================
+
+    For random starting points of 256 to 2048 bits, times the search for the
+    next prime by bignum_next_prime(), which sieves a window of candidates
+    by the small primes first, against testing consecutive odd numbers with
+    bignum_is_probable_prime(), and reports the cost of one full test of a
+    prime. Sizes that do not fit the build are skipped.
+
+    Usage: bench-bignum-prime [repetitions]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static uint32_t rng_state = 0x2545f491;
+
+static uint32_t xorshift32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Random number of exactly nbits bits */
+static void random_bn(struct bn* n, int nbits)
+{
+  int i;
+  bignum_init(n);
+  for (i = 0; i < nbits; ++i)
+  {
+    if ((i == nbits - 1) || (xorshift32() & 1))
+    {
+      n->array[i / (8 * WORD_SIZE)] |= (DTYPE)1 << (i % (8 * WORD_SIZE));
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const int width = BN_ARRAY_SIZE * WORD_SIZE * 8;
+  int reps = (argc > 1) ? atoi(argv[1]) : 4;
+  struct bn start[64], p, c;
+  int nbits, i;
+
+  if ((reps < 1) || (reps > 64))
+  {
+    fprintf(stderr, "repetitions: 1 .. 64\n");
+    return 1;
+  }
+
+  printf("%d repetitions, %d-bit numbers\n", reps, width);
+  printf("%6s %12s %12s %12s\n", "bits", "sieved/s", "one by one/s", "tests/s");
+
+  for (nbits = 256; nbits <= 2048; nbits *= 2)
+  {
+    if (nbits > width)
+    {
+      break;
+    }
+    for (i = 0; i < reps; ++i)
+    {
+      random_bn(&start[i], nbits);
+    }
+
+    double start_time = now();
+    for (i = 0; i < reps; ++i)
+    {
+      bignum_next_prime(&start[i], &p);
+    }
+    const double sieved_time = now() - start_time;
+
+    start_time = now();
+    for (i = 0; i < reps; ++i)
+    {
+      bignum_assign(&c, &start[i]);
+      bignum_inc(&c);
+      c.array[0] |= 1;
+      while (!bignum_is_probable_prime(&c))
+      {
+        bignum_inc(&c);
+        bignum_inc(&c);
+      }
+    }
+    const double naive_time = now() - start_time;
+
+    /* p is prime: every test runs all the way through */
+    start_time = now();
+    for (i = 0; i < reps; ++i)
+    {
+      bignum_is_probable_prime(&p);
+    }
+    const double test_time = now() - start_time;
+
+    printf("%6d %12.2f %12.2f %12.1f\n", nbits, reps / sieved_time, reps / naive_time, reps / test_time);
+  }
+
+  return 0;
+}
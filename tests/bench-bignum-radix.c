@@ -0,0 +1,151 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+    Radix conversion throughput
+    ===========================
+
+    Converts a random full-width number to and from text in several bases
+    and reports conversions per second, relative to the hex path
+    (bignum_to_string() / bignum_from_string()).
+
+    Usage: bench-bignum-radix [repetitions]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static uint32_t rng_state = 0x9e3779b9;
+
+static uint32_t xorshift32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Enough for the largest value in base 2 */
+#define MAX_DIGITS (BN_ARRAY_SIZE * WORD_SIZE * 8 + 1)
+
+enum { HEX = 0, RADIX, BASE58, BASE64 };
+
+static struct bn a, res;
+static char text[MAX_DIGITS];
+
+static int encode(int codec, int base)
+{
+  switch (codec)
+  {
+    case HEX:    return bignum_to_string(&a, text, sizeof(text));
+    case RADIX:  return bignum_to_radix(&a, text, sizeof(text), base);
+    case BASE58: return bignum_to_base58(&a, text, sizeof(text));
+    default:     return bignum_to_base64(&a, text, sizeof(text));
+  }
+}
+
+static int decode(int codec, int base, int len)
+{
+  switch (codec)
+  {
+    case HEX:    return bignum_from_string(&res, text, len);
+    case RADIX:  return bignum_from_radix(&res, text, len, base);
+    case BASE58: return bignum_from_base58(&res, text, len);
+    default:     return bignum_from_base64(&res, text, len);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  static const struct { const char* name; int codec; int base; } cases[] =
+  {
+    { "hex",         HEX,    16 },
+    { "radix 2",     RADIX,  2  },
+    { "radix 10",    RADIX,  10 },
+    { "radix 16",    RADIX,  16 },
+    { "radix 36",    RADIX,  36 },
+    { "radix 62",    RADIX,  62 },
+    { "base58",      BASE58, 58 },
+    { "base64",      BASE64, 64 },
+  };
+  int reps = (argc > 1) ? atoi(argv[1]) : 2000;
+  double hex_out = 0, hex_in = 0;
+  int i, c, len = 0;
+
+  for (i = 0; i < BN_ARRAY_SIZE; ++i)
+  {
+    a.array[i] = (DTYPE)xorshift32();
+  }
+
+  printf("%d repetitions, %d-bit numbers\n", reps, BN_ARRAY_SIZE * WORD_SIZE * 8);
+  printf("%-10s %8s %14s %14s\n", "", "digits", "encode/s", "decode/s");
+
+  for (c = 0; c < (int)(sizeof(cases) / sizeof(cases[0])); ++c)
+  {
+    double start = now();
+    for (i = 0; i < reps; ++i)
+    {
+      len = encode(cases[c].codec, cases[c].base);
+    }
+    double out = now() - start;
+
+    start = now();
+    for (i = 0; i < reps; ++i)
+    {
+      if (decode(cases[c].codec, cases[c].base, len) != BN_OK)
+      {
+        printf("%s: decoding failed\n", cases[c].name);
+        return 1;
+      }
+    }
+    double in = now() - start;
+
+    if (bignum_cmp(&res, &a) != EQUAL)
+    {
+      printf("%s: round trip differs\n", cases[c].name);
+      return 1;
+    }
+
+    if (c == 0)
+    {
+      hex_out = out;
+      hex_in = in;
+    }
+    printf("%-10s %8d %14.0f %14.0f  (%.2fx / %.2fx of hex)\n", cases[c].name, len, reps / out, reps / in, hex_out / out, hex_in / in);
+  }
+
+  return 0;
+}
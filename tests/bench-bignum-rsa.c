@@ -0,0 +1,121 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+    RSA key generation benchmark
+    ============================
+
+    Generates the same seeded keys on pools of 1, 2, ... N threads and
+    reports keys per second, the speedup relative to a single thread, and
+    whether every pool produced the very same keys (it must: the search
+    order does not depend on the threads). The keys' raw private and public
+    operations are checked against each other on the way.
+
+    Keys of more than 2048 bits need a wider struct bn, e.g.
+    `make clean bench DEFS=-DBN_ARRAY_SIZE=384` for 3072 bits (WORD_SIZE 4).
+
+    Usage: bench-bignum-rsa [max-threads] [keys] [modulus-bits]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+#include "../bignum-thread.h"
+#include "../bignum-rsa.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  int max_threads = (argc > 1) ? atoi(argv[1]) : (int)ncpu;
+  int count = (argc > 2) ? atoi(argv[2]) : 4;
+  int nbits = (argc > 3) ? atoi(argv[3]) : 1024;
+  int i, t;
+
+  if ((nbits < 16) || (nbits > BN_ARRAY_SIZE * WORD_SIZE * 8))
+  {
+    printf("%d-bit keys do not fit BN_ARRAY_SIZE\n", nbits);
+    return 1;
+  }
+
+  struct bn* first = malloc(count * sizeof(struct bn));
+  struct bn_rsa_key key;
+  struct bn m, c, back;
+
+  printf("%d x %d-bit RSA keys, %ld online CPUs\n", count, nbits, ncpu);
+  printf("threads    seconds     keys/s   speedup  same keys\n");
+
+  double base = 0;
+  for (t = 1; t <= max_threads; ++t)
+  {
+    struct bn_pool pool;
+    int same = 1;
+    bn_pool_init(&pool, t);
+
+    double start = now();
+    for (i = 0; i < count; ++i)
+    {
+      bn_rsa_keygen_seeded(&pool, &key, nbits, 65537, (uint64_t)i);
+      if (t == 1)
+      {
+        bignum_assign(&first[i], &key.n);
+      }
+      same &= (bignum_cmp(&first[i], &key.n) == EQUAL);
+    }
+    double elapsed = now() - start;
+
+    bn_pool_destroy(&pool);
+
+    if (t == 1)
+    {
+      base = elapsed;
+    }
+    printf("%7d %10.3f %10.2f %9.2f  %s\n", t, elapsed, count / elapsed, base / elapsed, same ? "yes" : "NO");
+  }
+
+  /* The last key: private undoes public */
+  bignum_from_int(&m, 0x5eed);
+  bn_rsa_public(&key, &m, &c);
+  bn_rsa_private(&key, &c, &back);
+  if (bignum_cmp(&m, &back) != EQUAL)
+  {
+    printf("private(public(m)) != m\n");
+    return 1;
+  }
+
+  free(first);
+
+  return 0;
+}
@@ -0,0 +1,174 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+    Compact store footprint and batch throughput
+    ============================================
+
+    Keeps a population of balances, nearly all of them 64-bit with one in
+    a hundred full-width, once as an array of struct bn and once in a
+    bn_store. Reports bytes per value of each, and the rate of batched
+    additions of 32-bit deltas and of summing all balances.
+
+    Usage: bench-bignum-store [values] [rounds]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+#include "../bignum-store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static uint32_t rng_state = 0x9e3779b9;
+
+static uint32_t xorshift32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* A 64-bit balance, or a full-width one for one value in a hundred */
+static void random_balance(struct bn* n)
+{
+  int i;
+  const int nbytes = ((xorshift32() % 100) == 0) ? (BN_ARRAY_SIZE * WORD_SIZE) : 8;
+
+  bignum_init(n);
+  for (i = 0; i < nbytes; i += WORD_SIZE)
+  {
+    n->array[i / WORD_SIZE] = (DTYPE)xorshift32();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const size_t count = (argc > 1) ? (size_t)atol(argv[1]) : 200000;
+  const int rounds = (argc > 2) ? atoi(argv[2]) : 10;
+  const size_t arena_limbs = BN_STORE_ARENA_LIMBS(2 * count, (8 + WORD_SIZE - 1) / WORD_SIZE + 1) + (count / 50 + 1) * BN_ARRAY_SIZE;
+  struct bn* plain = malloc(2 * count * sizeof(struct bn));
+  DTYPE* arena = malloc(arena_limbs * sizeof(DTYPE));
+  uint32_t* slots = malloc(2 * count * sizeof(uint32_t));
+  bn_handle* h = malloc(2 * count * sizeof(bn_handle));
+  struct bn_store s;
+  struct bn x, total, plain_total;
+  size_t i;
+  int r;
+
+  if (!plain || !arena || !slots || !h)
+  {
+    printf("out of memory\n");
+    return 1;
+  }
+
+  /* Balances first, then one 32-bit delta for each */
+  bn_store_init(&s, arena, arena_limbs, slots, 2 * count);
+  for (i = 0; i < count; ++i)
+  {
+    random_balance(&plain[i]);
+    bignum_from_int(&plain[count + i], xorshift32());
+  }
+  for (i = 0; i < 2 * count; ++i)
+  {
+    if (bn_store_add(&s, &plain[i], &h[i]) != BN_OK)
+    {
+      printf("store full\n");
+      return 1;
+    }
+  }
+
+  printf("%zu balances, %d-bit numbers\n", count, BN_ARRAY_SIZE * WORD_SIZE * 8);
+  printf("struct bn   %8.1f bytes/value\n", (double)sizeof(struct bn));
+  printf("bn_store    %8.1f bytes/value\n", (double)bn_store_bytes(&s) / (2 * count));
+
+  double start = now();
+  for (r = 0; r < rounds; ++r)
+  {
+    for (i = 0; i < count; ++i)
+    {
+      bignum_add(&plain[i], &plain[count + i], &plain[i]);
+    }
+  }
+  const double plain_add = now() - start;
+
+  start = now();
+  for (r = 0; r < rounds; ++r)
+  {
+    if (bn_store_add_many(&s, h, &h[count], count) != BN_OK)
+    {
+      printf("store full\n");
+      return 1;
+    }
+  }
+  const double store_add = now() - start;
+
+  start = now();
+  bignum_init(&plain_total);
+  for (i = 0; i < count; ++i)
+  {
+    bignum_add(&plain_total, &plain[i], &plain_total);
+  }
+  const double plain_sum = now() - start;
+
+  start = now();
+  bn_store_sum(&s, h, count, &total);
+  const double store_sum = now() - start;
+
+  for (i = 0; i < count; ++i)
+  {
+    bn_store_load(&s, h[i], &x);
+    if (bignum_cmp(&x, &plain[i]) != EQUAL)
+    {
+      printf("balance %zu differs\n", i);
+      return 1;
+    }
+  }
+  if (bignum_cmp(&total, &plain_total) != EQUAL)
+  {
+    printf("sums differ\n");
+    return 1;
+  }
+
+  printf("                 adds/s        sums/s\n");
+  printf("struct bn   %12.0f  %12.0f\n", rounds * count / plain_add, count / plain_sum);
+  printf("bn_store    %12.0f  %12.0f  (%.2fx / %.2fx)\n", rounds * count / store_add, count / store_sum, plain_add / store_add, plain_sum / store_sum);
+  printf("bn_store    %8.1f bytes/value after the additions\n", (double)bn_store_bytes(&s) / (2 * count));
+
+  free(plain);
+  free(arena);
+  free(slots);
+  free(h);
+  return 0;
+}
@@ -0,0 +1,127 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+    Streaming reduction throughput
+    ==============================
+
+    Feeds a few megabytes of decimal digits, hex digits and raw bytes to a
+    bn_reducer and reports the input rate in MB/s, for a small and a
+    full-width modulus.
+
+    Usage: bench-bignum-stream [megabytes]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+#include "../bignum-stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static uint32_t rng_state = 0x9e3779b9;
+
+static uint32_t xorshift32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill(char* buf, size_t len, int base)
+{
+  static const char digits[] = "0123456789abcdef";
+  size_t i;
+
+  for (i = 0; i < len; ++i)
+  {
+    uint32_t x = xorshift32();
+    buf[i] = (base == BN_REDUCER_BYTES) ? (char)x : digits[x % base];
+  }
+}
+
+int main(int argc, char** argv)
+{
+  static const struct { const char* name; int base; } cases[] =
+  {
+    { "decimal", 10 },
+    { "hex",     16 },
+    { "bytes",   BN_REDUCER_BYTES },
+  };
+  size_t len = (size_t)((argc > 1) ? atoi(argv[1]) : 4) << 20;
+  char* buf = malloc(len);
+  struct bn m[2], res;
+  struct bn_reducer r;
+  int c, k, i;
+
+  if (buf == NULL)
+  {
+    printf("out of memory\n");
+    return 1;
+  }
+
+  /* One limb, and all limbs but the top one */
+  bignum_from_int(&m[0], 1000003);
+  bignum_init(&m[1]);
+  for (i = 0; i < BN_ARRAY_SIZE - 1; ++i)
+  {
+    m[1].array[i] = (DTYPE)xorshift32();
+  }
+  m[1].array[BN_ARRAY_SIZE - 2] |= (DTYPE)1 << (8 * WORD_SIZE - 1);
+
+  printf("%zu MB of input, %d-bit numbers\n", len >> 20, BN_ARRAY_SIZE * WORD_SIZE * 8);
+  printf("%-10s %14s %14s\n", "", "1-limb MB/s", "wide MB/s");
+
+  for (c = 0; c < (int)(sizeof(cases) / sizeof(cases[0])); ++c)
+  {
+    fill(buf, len, cases[c].base);
+    printf("%-10s", cases[c].name);
+    for (k = 0; k < 2; ++k)
+    {
+      double start = now();
+      bn_reducer_init(&r, &m[k], cases[c].base);
+      if (bn_reducer_feed(&r, buf, len) != BN_OK || bn_reducer_result(&r, &res) != BN_OK)
+      {
+        printf("\n%s: reduction failed\n", cases[c].name);
+        return 1;
+      }
+      double elapsed = now() - start;
+      printf(" %14.1f", (len >> 20) / elapsed);
+    }
+    printf("\n");
+  }
+
+  free(buf);
+  return 0;
+}
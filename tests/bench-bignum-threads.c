@@ -0,0 +1,156 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+
+/*
+    Scaling benchmark for the thread pool
+    =====================================
+
+    Runs the same batch of independent bignum_pow_mod() jobs on pools of
+    1, 2, ... N threads and reports jobs per second and the speedup
+    relative to a single thread.
+
+    The operands are random, or taken from a corpus of 3 * jobs records:
+    the bases, then the exponents, then the moduli (see bignum-corpus.h).
+    Those are used in place, straight from the mapped file.
+
+    Usage: bench-bignum-threads [max-threads] [jobs] [modulus-bits] [corpus]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+#include "../bignum-thread.h"
+#include "../bignum-corpus.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint32_t rng_state = 0x2545f491;
+
+static uint32_t xorshift32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+/* Random number of exactly nbits bits */
+static void random_bn(struct bn* n, int nbits)
+{
+  int i;
+  bignum_init(n);
+  for (i = 0; i < nbits; ++i)
+  {
+    if ((i == nbits - 1) || (xorshift32() & 1))
+    {
+      n->array[i / (8 * WORD_SIZE)] |= (DTYPE)1 << (i % (8 * WORD_SIZE));
+    }
+  }
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  int max_threads = (argc > 1) ? atoi(argv[1]) : (int)ncpu;
+  int count = (argc > 2) ? atoi(argv[2]) : 32;
+  int nbits = (argc > 3) ? atoi(argv[3]) : 128;
+  int i, t;
+
+  struct bn_corpus corpus = { 0 };
+  const struct bn* a;
+  const struct bn* b;
+  const struct bn* n;
+  struct bn* operands = NULL;
+
+  if (argc > 4)
+  {
+    if (bn_corpus_open(&corpus, argv[4]) != BN_OK)
+    {
+      printf("%s: cannot load a corpus for this WORD_SIZE / BN_ARRAY_SIZE\n", argv[4]);
+      return 1;
+    }
+    count = (int)(corpus.count / 3);
+    a = &corpus.records[0];
+    b = &corpus.records[count];
+    n = &corpus.records[2 * count];
+    nbits = 8 * bignum_nbytes(&n[0]);
+  }
+  else
+  {
+    require(nbits * 2 <= BN_ARRAY_SIZE * WORD_SIZE * 8, "modulus too large for BN_ARRAY_SIZE");
+
+    operands = malloc(3 * count * sizeof(struct bn));
+    for (i = 0; i < count; ++i)
+    {
+      random_bn(&operands[2 * count + i], nbits);
+      operands[2 * count + i].array[0] |= 1;
+      random_bn(&operands[i], nbits - 1);
+      random_bn(&operands[count + i], nbits);
+    }
+    a = &operands[0];
+    b = &operands[count];
+    n = &operands[2 * count];
+  }
+
+  struct bn* res = malloc(count * sizeof(struct bn));
+
+  printf("%d x bignum_pow_mod, %d-bit operands, %ld online CPUs\n", count, nbits, ncpu);
+  printf("threads    seconds     jobs/s   speedup\n");
+
+  double base = 0;
+  for (t = 1; t <= max_threads; ++t)
+  {
+    struct bn_pool pool;
+    bn_pool_init(&pool, t);
+
+    double start = now();
+    bignum_pow_mod_many(&pool, a, b, n, res, count);
+    double elapsed = now() - start;
+
+    bn_pool_destroy(&pool);
+
+    if (t == 1)
+    {
+      base = elapsed;
+    }
+    printf("%7d %10.3f %10.1f %9.2f\n", t, elapsed, count / elapsed, base / elapsed);
+  }
+
+  free(operands);
+  free(res);
+  bn_corpus_close(&corpus);
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+    RSA verification throughput
+    ===========================
+
+    Times the public operation s^e mod n for e = 3 and e = 65537 with
+    moduli of 512 to 4096 bits: by bignum_pow_mod() with e as a struct bn,
+    the same with the cache of moduli cleared before every call (what each
+    call cost before the cache), and by bignum_pow_mod_word(). The three
+    must agree. Sizes that do not fit the build are skipped.
+
+    Usage: bench-bignum-verify [repetitions]
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static uint32_t rng_state = 0x2545f491;
+
+static uint32_t xorshift32(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Random number of exactly nbits bits */
+static void random_bn(struct bn* n, int nbits)
+{
+  int i;
+  bignum_init(n);
+  for (i = 0; i < nbits; ++i)
+  {
+    if ((i == nbits - 1) || (xorshift32() & 1))
+    {
+      n->array[i / (8 * WORD_SIZE)] |= (DTYPE)1 << (i % (8 * WORD_SIZE));
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  static const DTYPE_TMP exponents[] = { 3, 65537 };
+  const int width = BN_ARRAY_SIZE * WORD_SIZE * 8;
+  int reps = (argc > 1) ? atoi(argv[1]) : 200;
+  struct bn n, s, e, generic, word;
+  int nbits, i, k;
+  int same = 1;
+
+  printf("%d repetitions, %d-bit numbers, %d cached moduli\n", reps, width, BN_MODCACHE_SIZE);
+  printf("%6s %6s %12s %12s %12s %9s\n", "bits", "e", "uncached/s", "pow_mod/s", "word/s", "speedup");
+
+  for (nbits = 512; nbits <= 4096; nbits *= 2)
+  {
+    if (nbits > width)
+    {
+      break;
+    }
+
+    /* Timing only: any odd n costs the same as an RSA modulus */
+    random_bn(&n, nbits);
+    n.array[0] |= 1;
+    random_bn(&s, nbits - 1);
+
+    for (k = 0; k < (int)(sizeof(exponents) / sizeof(*exponents)); ++k)
+    {
+      bignum_from_int(&e, exponents[k]);
+
+      double start = now();
+      for (i = 0; i < reps; ++i)
+      {
+        bignum_modcache_clear();
+        bignum_pow_mod(&s, &e, &n, &generic);
+      }
+      const double uncached_time = now() - start;
+
+      start = now();
+      for (i = 0; i < reps; ++i)
+      {
+        bignum_pow_mod(&s, &e, &n, &generic);
+      }
+      const double generic_time = now() - start;
+
+      start = now();
+      for (i = 0; i < reps; ++i)
+      {
+        bignum_pow_mod_word(&s, exponents[k], &n, &word);
+      }
+      const double word_time = now() - start;
+
+      same &= (bignum_cmp(&generic, &word) == EQUAL);
+      printf("%6d %6lu %12.0f %12.0f %12.0f %9.2f\n", nbits, (unsigned long)exponents[k],
+             reps / uncached_time, reps / generic_time, reps / word_time, uncached_time / word_time);
+    }
+  }
+
+  if (!same)
+  {
+    printf("bignum_pow_mod_word() disagrees with bignum_pow_mod()\n");
+    return 1;
+  }
+
+  return 0;
+}
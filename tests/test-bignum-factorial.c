@@ -85,5 +85,11 @@ int main() {
   printf("factorial(100) using bignum = %s\n", buf);
   assert(strcmp("1b30964ec395dc24069528d54bbda40d16e966ef9a70eb21b5b2943a321cdf10391745570cca9420c6ecb3b72ed2ee8b02ea2735c61a000000000000000000000000", buf) == 0);
 
+  /* Same result from the balanced product tree */
+  bignum_factorial(100, &num);
+  bignum_to_string(&num, buf, sizeof(buf));
+  printf("factorial(100) using bignum_factorial = %s\n", buf);
+  assert(bignum_cmp(&num, &result) == EQUAL);
+
   return 0;
 }
@@ -0,0 +1,176 @@
+// This is free and unencumbered software released into the public domain.
+// 
+// Anyone is free to copy, modify, publish, use, compile, sell, or
+// distribute this software, either in source code form or as a compiled
+// binary, for any purpose, commercial or non-commercial, and by any
+// means.
+// 
+// In jurisdictions that recognize copyright laws, the author or authors
+// of this software dedicate any and all copyright interest in the
+// software to the public domain. We make this dedication for the benefit
+// of the public at large and to the detriment of our heirs and
+// successors. We intend this dedication to be an overt act of
+// relinquishment in perpetuity of all present and future rights to this
+// software under copyright law.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// For more information, please refer to <https://unlicense.org>
+/*
+    Corpus converter
+    ================
+
+    Converts numbers written as text, hex by default (with or without 0x)
+    or decimal with -d, into a binary corpus for bn_corpus_open(), or
+    prints the records of a corpus back as hex with -p. Numbers are
+    separated by whitespace or commas, and # starts a comment.
+
+    A corpus only loads into a build with the same WORD_SIZE and
+    BN_ARRAY_SIZE, so convert with the same DEFS as the program that reads it.
+
+    Usage: tool-bignum-corpus [-d] corpus [text-file]
+           tool-bignum-corpus -p corpus
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../bignum.h"
+#include "../bignum-corpus.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Longest number accepted: the largest value in decimal, or in hex with 0x */
+#define MAX_TOKEN ((BN_ARRAY_SIZE * WORD_SIZE * 8) * 302 / 1000 + 4)
+
+/* Records are written in batches of this many */
+#define BATCH 256
+
+static struct bn batch[BATCH];
+static char token[MAX_TOKEN + 1];
+
+/* Next number from f into token, returns its length, 0 at the end of input and -1 if too long */
+static int next_token(FILE* f)
+{
+  int c, len = 0;
+
+  while ((c = getc(f)) != EOF)
+  {
+    if (c == '#')
+    {
+      while ((c != EOF) && (c != '\n'))
+      {
+        c = getc(f);
+      }
+    }
+    if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == ',') || (c == EOF))
+    {
+      if (len > 0)
+      {
+        break;
+      }
+      continue;
+    }
+    if (len == MAX_TOKEN)
+    {
+      return -1;
+    }
+    token[len++] = (char)c;
+  }
+  token[len] = 0;
+  return len;
+}
+
+static int print_corpus(const char* path)
+{
+  struct bn_corpus c;
+  char text[BN_ARRAY_SIZE * WORD_SIZE * 2 + 1];
+  size_t i;
+
+  const int status = bn_corpus_open(&c, path);
+  if (status != BN_OK)
+  {
+    fprintf(stderr, "%s: %s\n", path, (status == BN_INVALID) ? "not a corpus for this WORD_SIZE / BN_ARRAY_SIZE" : "cannot read");
+    return 1;
+  }
+  for (i = 0; i < c.count; ++i)
+  {
+    bignum_to_string(&c.records[i], text, sizeof(text));
+    printf("%s\n", text);
+  }
+  bn_corpus_close(&c);
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  struct bn_corpus_writer w;
+  FILE* in = stdin;
+  int decimal = 0;
+  int n = 0, len, status;
+  long index = 0;
+
+  if ((argc == 3) && (strcmp(argv[1], "-p") == 0))
+  {
+    return print_corpus(argv[2]);
+  }
+  if ((argc > 1) && (strcmp(argv[1], "-d") == 0))
+  {
+    decimal = 1;
+    argc -= 1;
+    argv += 1;
+  }
+  if ((argc < 2) || (argc > 3))
+  {
+    fprintf(stderr, "usage: tool-bignum-corpus [-d] corpus [text-file]\n"
+                    "       tool-bignum-corpus -p corpus\n");
+    return 2;
+  }
+  if ((argc == 3) && ((in = fopen(argv[2], "r")) == NULL))
+  {
+    perror(argv[2]);
+    return 1;
+  }
+
+  if (bn_corpus_create(&w, argv[1]) != BN_OK)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  while ((len = next_token(in)) != 0)
+  {
+    index += 1;
+    if (len < 0)
+    {
+      fprintf(stderr, "number %ld: too long\n", index);
+      return 1;
+    }
+    status = decimal ? bignum_from_decimal(&batch[n], token, len) : bignum_from_string(&batch[n], token, len);
+    if (status != BN_OK)
+    {
+      fprintf(stderr, "number %ld: %s\n", index, (status == BN_OVERFLOW) ? "does not fit in BN_ARRAY_SIZE" : "not a number");
+      return 1;
+    }
+    if (++n == BATCH)
+    {
+      bn_corpus_append(&w, batch, n);
+      n = 0;
+    }
+  }
+  bn_corpus_append(&w, batch, n);
+
+  if (bn_corpus_finish(&w) != BN_OK)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  fprintf(stderr, "%lu numbers\n", (unsigned long)w.count);
+  return 0;
+}
@@ -24,9 +24,17 @@
 // For more information, please refer to <https://unlicense.org>
 
 #include "bignum.h"
+#include "bignum-thread.h"
+#include "bignum-stream.h"
+#include "bignum-corpus.h"
+#include "bignum-store.h"
+#include "bignum-rsa.h"
 
+#include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "test_harness.h"
 
@@ -506,7 +514,7 @@ static void factorial(struct bn* n, struct bn* res) {
   bignum_assign(res, &tmp);
 }
 
-TEST_F(bignum, factorial) {
+TEST_F(bignum, naive_factorial) {
   struct bn num;
   struct bn result;
   char buf[8192];
@@ -849,6 +857,1493 @@ TEST_F(bignum, rsa_simple) {
   EXPECT_EQ(strcmp(buf, "7b"), 0); // 0x007b = 123
 }
 
+/*
+ * Lane-interleaved exponentiation must agree with bignum_pow_mod,
+ * including the lanes that fall back to it (even and tiny moduli).
+ */
+
+TEST_F(bignum, pow_mod_lanes) {
+  static const char* moduli[8] = {
+    "00000ca1", "9f2a8b3d7c6e5f41", "000000010000001b", "00000000000000000000000000000100",
+    "c3d2e1f0a1b2c3d4e5f60718293a4b5d", "00000001", "ffffffffffffffffffffffffffffff61", "00000002",
+  };
+  struct bn a[8], b[8], n[8], res[8], expected;
+  int i;
+
+  for (i = 0; i < 8; ++i) {
+    bignum_from_string(&n[i], moduli[i], strlen(moduli[i]));
+    bignum_from_int(&a[i], 0x123456789abcdefULL + i * 7919);
+    bignum_from_int(&b[i], (i == 5) ? 0 : 0x10001ULL + i * 0x3456789ULL);
+  }
+
+  bignum_pow_mod_x8(a, b, n, res);
+  for (i = 0; i < 8; ++i) {
+    bignum_pow_mod(&a[i], &b[i], &n[i], &expected);
+    EXPECT_EQ(bignum_cmp(&res[i], &expected), EQUAL) TH_LOG("lane %d", i);
+  }
+
+  bignum_pow_mod_x4(a + 4, b + 4, n + 4, res);
+  for (i = 0; i < 4; ++i) {
+    bignum_pow_mod(&a[i + 4], &b[i + 4], &n[i + 4], &expected);
+    EXPECT_EQ(bignum_cmp(&res[i], &expected), EQUAL) TH_LOG("lane %d", i);
+  }
+}
+
+/*
+ * Thread pool: every job runs exactly once, batches match single calls.
+ */
+
+static void count_job(void* ctx, size_t index, int worker) {
+  int* hits = ctx;
+  hits[index] += 1;
+}
+
+TEST_F(bignum, thread_pool) {
+  enum { JOBS = 37 };
+  struct bn_pool pool;
+  struct bn a[JOBS], b[JOBS], n[JOBS], c[JOBS], d[JOBS], expected, rem;
+  int hits[1000];
+  int i, round;
+
+  ASSERT_EQ(bn_pool_init(&pool, 4), 0);
+
+  for (round = 0; round < 3; ++round) {
+    memset(hits, 0, sizeof(hits));
+    bn_pool_run(&pool, 1000, count_job, hits);
+    for (i = 0; i < 1000; ++i) {
+      EXPECT_EQ(hits[i], 1) TH_LOG("job %d", i);
+    }
+  }
+
+  for (i = 0; i < JOBS; ++i) {
+    bignum_from_int(&a[i], 0xfedcba9876543ULL * (i + 1));
+    bignum_from_int(&b[i], 0x1234567ULL + i);
+    bignum_from_int(&n[i], 0x10000000fULL + 2 * i);
+  }
+
+  bignum_mul_many(&pool, a, b, c, JOBS);
+  for (i = 0; i < JOBS; ++i) {
+    bignum_mul(&a[i], &b[i], &expected);
+    EXPECT_EQ(bignum_cmp(&c[i], &expected), EQUAL) TH_LOG("mul %d", i);
+  }
+
+  bignum_divmod_many(&pool, a, b, c, d, JOBS);
+  for (i = 0; i < JOBS; ++i) {
+    bignum_divmod(&a[i], &b[i], &expected, &rem);
+    EXPECT_EQ(bignum_cmp(&c[i], &expected), EQUAL) TH_LOG("div %d", i);
+    EXPECT_EQ(bignum_cmp(&d[i], &rem), EQUAL) TH_LOG("mod %d", i);
+  }
+
+  bignum_pow_mod_many(&pool, a, b, n, c, JOBS);
+  for (i = 0; i < JOBS; ++i) {
+    bignum_pow_mod(&a[i], &b[i], &n[i], &expected);
+    EXPECT_EQ(bignum_cmp(&c[i], &expected), EQUAL) TH_LOG("pow_mod %d", i);
+  }
+
+  bn_pool_destroy(&pool);
+}
+
+/*
+ * Parallel multiplication gives the same (truncated) product as bignum_mul.
+ */
+
+TEST_F(bignum, parallel_mul) {
+  struct bn_pool pool;
+  struct bn a, b, c, expected;
+  int i, round;
+
+  ASSERT_EQ(bn_pool_init(&pool, 3), 0);
+  pool.mul_threshold = 1;
+
+  for (round = 0; round < 4; ++round) {
+    bignum_init(&a);
+    bignum_init(&b);
+    for (i = 0; i < BN_ARRAY_SIZE; ++i) {
+      a.array[i] = (DTYPE)(0x9e3779b97f4a7c15ULL * (i + 1) >> (round * 8));
+      if (i < BN_ARRAY_SIZE / (round + 1))
+        b.array[i] = (DTYPE)(0xc2b2ae3d27d4eb4fULL * (i + 3) >> 16);
+    }
+    bignum_mul(&a, &b, &expected);
+    bignum_mul_parallel(&pool, &a, &b, &c);
+    EXPECT_EQ(bignum_cmp(&c, &expected), EQUAL) TH_LOG("round %d", round);
+  }
+
+  bn_pool_destroy(&pool);
+}
+
+/*
+ * Product tree: bignum_factorial and bignum_product_range against the
+ * naive running product, serial and with independent subtrees on threads.
+ */
+
+TEST_F(bignum, product_tree) {
+  struct bn_pool pool;
+  struct bn num, expected, result, k;
+  char buf[8192];
+  uint32_t i;
+
+  bignum_factorial(100, &result);
+  bignum_to_string(&result, buf, sizeof(buf));
+  EXPECT_FALSE(strcmp("1b30964ec395dc24069528d54bbda40d16e966ef9a70eb21b5b2943a321cdf10391745570cca9420c6ecb3b72ed2ee8b02ea2735c61a000000000000000000000000", buf));
+
+  bignum_factorial(0, &result);
+  bignum_from_int(&num, 1);
+  EXPECT_EQ(bignum_cmp(&result, &num), EQUAL);
+
+  bignum_product_range(7, 6, &result);
+  EXPECT_EQ(bignum_cmp(&result, &num), EQUAL);
+
+  bignum_product_range(0, 6, &result);
+  EXPECT_TRUE(bignum_is_zero(&result));
+
+  /* Wide factors and a product that wraps around */
+  bignum_from_int(&expected, 1);
+  for (i = 4000000000u; i <= 4000000100u; ++i) {
+    bignum_from_int(&k, i);
+    bignum_mul(&expected, &k, &expected);
+  }
+  bignum_product_range(4000000000u, 4000000100u, &result);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+
+  bignum_from_int(&expected, 1);
+  for (i = 1; i <= 1000; ++i) {
+    bignum_from_int(&k, i);
+    bignum_mul(&expected, &k, &expected);
+  }
+  bignum_factorial(1000, &result);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+
+  ASSERT_EQ(bn_pool_init(&pool, 3), 0);
+  bignum_factorial_parallel(&pool, 1000, &result);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+  bignum_product_range_parallel(&pool, 4000000000u, 4000000100u, &result);
+  bignum_product_range(4000000000u, 4000000100u, &expected);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+  bn_pool_destroy(&pool);
+}
+
+/*
+ * Prime swing: factorials agree with the product tree, binomials with
+ * factorial quotients, on both sides of BN_SIEVE_LIMIT.
+ */
+
+TEST_F(bignum, prime_swing) {
+  enum { ROWS = 52 };
+  struct bn expected, result, denom;
+  struct bn* row;
+  char* wrapped;
+  char buf[8192];
+  uint32_t n, k, half, i;
+
+  for (n = 0; n < 300; n += 7) {
+    bignum_factorial(n, &expected);
+    bignum_factorial_swing(n, &result);
+    EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL) TH_LOG("%u!", n);
+  }
+
+  bignum_binomial(10, 3, &result);
+  EXPECT_EQ(bignum_to_int(&result), 120);
+  bignum_binomial(3, 10, &result);
+  EXPECT_TRUE(bignum_is_zero(&result));
+  bignum_binomial(0, 0, &result);
+  EXPECT_EQ(bignum_to_int(&result), 1);
+
+  /* C(100, 50) = 100891344545564193334812497256 */
+  bignum_binomial(100, 50, &result);
+  bignum_to_string(&result, buf, sizeof(buf));
+  EXPECT_STREQ("145ff5d3b1070380dc8085568", buf);
+
+  for (n = 2; n < 200; n += 13) {
+    for (k = 0; k <= n; k += 5) {
+      bignum_factorial(k, &expected);
+      bignum_factorial(n - k, &denom);
+      bignum_mul(&expected, &denom, &denom);
+      bignum_factorial(n, &expected);
+      bignum_div(&expected, &denom, &expected);
+      bignum_binomial(n, k, &result);
+      EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL) TH_LOG("C(%u, %u)", n, k);
+    }
+  }
+
+  /* Beyond the sieve: C(n, 3) = n (n-1) (n-2) / 6 */
+  n = BN_SIEVE_LIMIT + 1000;
+  bignum_product_range(n - 2, n, &expected);
+  bignum_from_int(&denom, 6);
+  bignum_div(&expected, &denom, &expected);
+  bignum_binomial(n, 3, &result);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+  bignum_binomial(n, n - 3, &result);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+
+  /*
+   * Near the width: Pascal's rule carries row BN_SIEVE_LIMIT of the sieve
+   * ROWS rows further, flagging the sums that wrapped; the largest k left
+   * is C(n, k) closest to the limit.
+   */
+  n = BN_SIEVE_LIMIT + ROWS;
+  half = n / 2;
+  row = malloc((half + 1) * sizeof(struct bn));
+  wrapped = calloc(half + 1, 1);
+  ASSERT_TRUE(row && wrapped);
+  for (k = 0; k <= half; ++k) {
+    bignum_binomial(BN_SIEVE_LIMIT, k, &row[k]);
+  }
+  for (i = 1; i <= ROWS; ++i) {
+    for (k = half; k > 0; --k) {
+      bignum_add(&row[k], &row[k - 1], &row[k]);
+      wrapped[k] |= wrapped[k - 1] | (bignum_cmp(&row[k], &row[k - 1]) == SMALLER);
+    }
+  }
+  for (k = half; wrapped[k]; --k) {
+  }
+  EXPECT_LT(k, half);
+  for (i = 0; i < 8; ++i) {
+    bignum_binomial(n, k - i * i, &result);
+    EXPECT_EQ(bignum_cmp(&result, &row[k - i * i]), EQUAL) TH_LOG("C(%u, %u)", n, k - i * i);
+  }
+  bignum_binomial(n, n - k, &result);
+  EXPECT_EQ(bignum_cmp(&result, &row[k]), EQUAL);
+  free(row);
+  free(wrapped);
+}
+
+TEST_F(bignum, hex_output) {
+  enum { DIGITS = BN_ARRAY_SIZE * WORD_SIZE * 2 + 1 };
+  struct bn a;
+  char buf[DIGITS], expected[DIGITS];
+  int i, j, len;
+
+  bignum_init(&a);
+  EXPECT_EQ(bignum_to_string(&a, NULL, 0), 1);
+  EXPECT_EQ(bignum_to_string(&a, buf, sizeof(buf)), 1);
+  EXPECT_STREQ("0", buf);
+
+  bignum_from_int(&a, 0xabc123);
+  EXPECT_EQ(bignum_to_string(&a, buf, sizeof(buf)), 6);
+  EXPECT_STREQ("abc123", buf);
+  /* Truncates like snprintf() and still reports the full length */
+  EXPECT_EQ(bignum_to_string(&a, buf, 4), 6);
+  EXPECT_STREQ("abc", buf);
+  EXPECT_EQ(bignum_to_string(&a, buf, 1), 6);
+  EXPECT_STREQ("", buf);
+
+  /* Against one sprintf() per limb, with every length of top limb */
+  for (i = 0; i < 2 * BN_ARRAY_SIZE * WORD_SIZE; i += 3) {
+    bignum_init(&a);
+    for (j = 0; j <= i / (2 * WORD_SIZE); ++j) {
+      a.array[j] = (DTYPE)(0x9e3779b9u * (j + 1));
+    }
+    bignum_rshift(&a, &a, 4 * ((2 * WORD_SIZE) - 1 - (i % (2 * WORD_SIZE))));
+
+    len = 0;
+    for (j = BN_ARRAY_SIZE - 1; j >= 0; --j) {
+      if ((len > 0) || (a.array[j] != 0)) {
+        len += sprintf(&expected[len], (len > 0) ? SPRINTF_FORMAT_STR : "%x", a.array[j]);
+      }
+    }
+    if (len == 0) {
+      len = sprintf(expected, "0");
+    }
+
+    EXPECT_EQ(bignum_to_string(&a, NULL, 0), len);
+    EXPECT_EQ(bignum_to_string(&a, buf, sizeof(buf)), len);
+    EXPECT_STREQ(expected, buf);
+    EXPECT_EQ(bignum_to_string(&a, buf, len), len);
+    EXPECT_EQ(strncmp(expected, buf, len - 1), 0);
+    EXPECT_EQ(buf[len - 1], 0);
+  }
+}
+
+TEST_F(bignum, hex_input) {
+  enum { DIGITS = BN_ARRAY_SIZE * WORD_SIZE * 2 + 4 }; /* with three leading zeros, or one digit too many */
+  struct bn a, b;
+  char buf[DIGITS];
+  int i, len;
+
+  EXPECT_EQ(bignum_from_string(&a, "abc123", 6), BN_OK);
+  EXPECT_EQ(bignum_to_int(&a), 0xabc123);
+  EXPECT_EQ(bignum_from_string(&a, "0xABC123", 8), BN_OK);
+  EXPECT_EQ(bignum_to_int(&a), 0xabc123);
+  EXPECT_EQ(bignum_from_string(&a, "0X1", 3), BN_OK);
+  EXPECT_EQ(bignum_to_int(&a), 1);
+  EXPECT_EQ(bignum_from_string(&a, "00000", 5), BN_OK);
+  EXPECT_TRUE(bignum_is_zero(&a));
+  /* Only nbytes characters are read */
+  EXPECT_EQ(bignum_from_string(&a, "fffz", 3), BN_OK);
+  EXPECT_EQ(bignum_to_int(&a), 0xfff);
+
+  EXPECT_EQ(bignum_from_string(&a, "", 0), BN_INVALID);
+  EXPECT_EQ(bignum_from_string(&a, "0x", 2), BN_INVALID);
+  EXPECT_EQ(bignum_from_string(&a, "12g4", 4), BN_INVALID);
+  EXPECT_TRUE(bignum_is_zero(&a));
+  EXPECT_EQ(bignum_from_string(&a, "0x0x1", 5), BN_INVALID);
+  EXPECT_EQ(bignum_from_string(&a, " 1", 2), BN_INVALID);
+
+  /* Round trips through bignum_to_string() at every length, with and without leading zeros */
+  for (i = 1; i < 2 * BN_ARRAY_SIZE * WORD_SIZE; i += 5) {
+    bignum_from_int(&b, 1);
+    bignum_lshift(&b, &b, 4 * i);
+    bignum_dec(&b);
+    bignum_from_int(&a, 0x5a5a5a5a);
+    bignum_xor(&b, &a, &b);
+    len = bignum_to_string(&b, buf + 3, sizeof(buf) - 3);
+    EXPECT_EQ(bignum_from_string(&a, buf + 3, len), BN_OK);
+    EXPECT_EQ(bignum_cmp(&a, &b), EQUAL) TH_LOG("%s", buf + 3);
+    buf[0] = '0';
+    buf[1] = '0';
+    buf[2] = '0';
+    EXPECT_EQ(bignum_from_string(&a, buf, len + 3), BN_OK);
+    EXPECT_EQ(bignum_cmp(&a, &b), EQUAL);
+  }
+
+  /* The largest value fits, one more digit does not */
+  bignum_init(&b);
+  bignum_dec(&b);
+  len = bignum_to_string(&b, buf, sizeof(buf));
+  EXPECT_EQ(bignum_from_string(&a, buf, len), BN_OK);
+  EXPECT_EQ(bignum_cmp(&a, &b), EQUAL);
+  buf[len] = '1';
+  EXPECT_EQ(bignum_from_string(&a, buf, len + 1), BN_OVERFLOW);
+}
+
+TEST_F(bignum, byte_order) {
+  struct bn a, b;
+  uint8_t be[2 * sizeof(a.array) + 4], le[2 * sizeof(a.array) + 4]; /* a value and its padded copy */
+  char buf[1024];
+  int i, j, len;
+
+  const uint8_t msg[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a };
+  EXPECT_EQ(bignum_from_bytes_be(&a, msg, sizeof(msg)), BN_OK);
+  bignum_to_string(&a, buf, sizeof(buf));
+  EXPECT_STREQ("102030405060708090a", buf);
+  EXPECT_EQ(bignum_nbytes(&a), 10);
+  EXPECT_EQ(bignum_from_bytes_le(&a, msg, sizeof(msg)), BN_OK);
+  bignum_to_string(&a, buf, sizeof(buf));
+  EXPECT_STREQ("a09080706050403020100", buf);
+  EXPECT_EQ(bignum_nbytes(&a), 11);
+  EXPECT_EQ(bignum_nbits(&a), 84);
+
+  /* Fixed-length output is zero-padded, and too short a buffer is an error */
+  EXPECT_EQ(bignum_to_bytes_be(&a, be, 12), BN_OK);
+  EXPECT_EQ(be[0], 0);
+  EXPECT_EQ(be[1], 0x0a);
+  EXPECT_EQ(be[10], 0x01);
+  EXPECT_EQ(be[11], 0);
+  EXPECT_EQ(bignum_to_bytes_le(&a, le, 12), BN_OK);
+  EXPECT_EQ(le[0], 0);
+  EXPECT_EQ(le[1], 0x01);
+  EXPECT_EQ(le[10], 0x0a);
+  EXPECT_EQ(le[11], 0);
+  EXPECT_EQ(bignum_to_bytes_be(&a, be, 10), BN_OVERFLOW);
+  EXPECT_EQ(bignum_to_bytes_le(&a, le, 10), BN_OVERFLOW);
+
+  bignum_init(&a);
+  EXPECT_EQ(bignum_nbytes(&a), 0);
+  EXPECT_EQ(bignum_nbits(&a), 0);
+  EXPECT_EQ(bignum_to_bytes_be(&a, be, 0), BN_OK);
+  EXPECT_EQ(bignum_from_bytes_be(&a, be, 0), BN_OK);
+  EXPECT_TRUE(bignum_is_zero(&a));
+
+  /* Round trips at every length, up to the full width plus zero padding */
+  for (len = 1; len <= (int)sizeof(a.array); ++len) {
+    for (i = 0; i < len; ++i) {
+      be[i] = (uint8_t)(0x9e * (i + 1) + len);
+      le[len - 1 - i] = be[i];
+    }
+    be[0] |= 1;
+    le[len - 1] |= 1;
+
+    EXPECT_EQ(bignum_from_bytes_be(&a, be, len), BN_OK);
+    EXPECT_EQ(bignum_from_bytes_le(&b, le, len), BN_OK);
+    EXPECT_EQ(bignum_cmp(&a, &b), EQUAL) TH_LOG("%d bytes", len);
+    EXPECT_EQ(bignum_nbytes(&a), len);
+
+    EXPECT_EQ(bignum_to_bytes_be(&a, &be[len], len + 3), BN_OK);
+    EXPECT_EQ(bignum_to_bytes_le(&a, &le[len], len + 3), BN_OK);
+    for (j = 0; j < 3; ++j) {
+      EXPECT_EQ(be[len + j], 0);
+      EXPECT_EQ(le[2 * len + j], 0);
+    }
+    EXPECT_EQ(memcmp(&be[len + 3], be, len), 0);
+    EXPECT_EQ(memcmp(&le[len], le, len), 0);
+    EXPECT_EQ(bignum_from_bytes_be(&b, &be[len], len + 3), BN_OK);
+    EXPECT_EQ(bignum_cmp(&a, &b), EQUAL);
+    EXPECT_EQ(bignum_from_bytes_le(&b, &le[len], len + 3), BN_OK);
+    EXPECT_EQ(bignum_cmp(&a, &b), EQUAL);
+  }
+
+  /* One significant byte more than the width */
+  memset(be, 0, sizeof(be));
+  be[0] = 1;
+  EXPECT_EQ(bignum_from_bytes_be(&a, be, sizeof(a.array) + 1), BN_OVERFLOW);
+  EXPECT_EQ(bignum_from_bytes_be(&a, &be[1], sizeof(a.array) + 1), BN_OK);
+  EXPECT_EQ(bignum_from_bytes_le(&a, be, sizeof(a.array) + 1), BN_OK);
+  EXPECT_EQ(bignum_from_bytes_le(&a, &be[1], sizeof(a.array) + 1), BN_OK);
+  le[sizeof(a.array)] = 1;
+  EXPECT_EQ(bignum_from_bytes_le(&a, le, sizeof(a.array) + 1), BN_OVERFLOW);
+}
+
+TEST_F(bignum, decimal_output) {
+  enum { DIGITS = BN_ARRAY_SIZE * WORD_SIZE * 8 * 302 / 1000 + 2 }; /* log10(2) < 0.302, and the terminator */
+  struct bn a, b, q, r, ten;
+  char buf[DIGITS], naive[DIGITS];
+  int i, j, len;
+
+  bignum_init(&a);
+  EXPECT_EQ(bignum_to_decimal(&a, buf, sizeof(buf)), 1);
+  EXPECT_STREQ("0", buf);
+
+  bignum_from_int(&a, 1234567);
+  EXPECT_EQ(bignum_to_decimal(&a, buf, sizeof(buf)), 7);
+  EXPECT_STREQ("1234567", buf);
+  /* Truncates like snprintf() and still reports the full length */
+  EXPECT_EQ(bignum_to_decimal(&a, buf, 4), 7);
+  EXPECT_STREQ("123", buf);
+  EXPECT_EQ(bignum_to_decimal(&a, NULL, 0), 7);
+
+  /* 2^100 and 10^40 exercise the zero-filled low halves */
+  bignum_from_int(&a, 1);
+  bignum_lshift(&a, &a, 100);
+  bignum_to_decimal(&a, buf, sizeof(buf));
+  EXPECT_STREQ("1267650600228229401496703205376", buf);
+  bignum_from_int(&ten, 10);
+  bignum_from_int(&b, 40);
+  bignum_pow(&ten, &b, &a);
+  bignum_to_decimal(&a, buf, sizeof(buf));
+  EXPECT_STREQ("10000000000000000000000000000000000000000", buf);
+
+  /* Compare against one digit per division, on numbers up to the full width */
+  for (i = 0; i < 8; ++i) {
+    bignum_factorial(20 + 37 * i, &a);
+    bignum_dec(&a);
+    if (i == 7) {
+      bignum_init(&a);
+      bignum_dec(&a);
+    }
+
+    len = 0;
+    bignum_assign(&q, &a);
+    while (!bignum_is_zero(&q)) {
+      bignum_divmod(&q, &ten, &q, &r);
+      naive[len++] = '0' + bignum_to_int(&r);
+    }
+    naive[len] = 0;
+    for (j = 0; j < len / 2; ++j) {
+      char c = naive[j];
+      naive[j] = naive[len - 1 - j];
+      naive[len - 1 - j] = c;
+    }
+
+    EXPECT_EQ(bignum_to_decimal(&a, buf, sizeof(buf)), len);
+    EXPECT_STREQ(naive, buf);
+  }
+
+  /* Long division: a = q * b + r with r < b */
+  bignum_init(&a);
+  bignum_dec(&a);
+  for (i = 1; i < 300; i += 11) {
+    bignum_factorial(i, &b);
+    bignum_divmod(&a, &b, &q, &r);
+    EXPECT_EQ(bignum_cmp(&r, &b), SMALLER);
+    bignum_mul(&q, &b, &q);
+    bignum_add(&q, &r, &q);
+    EXPECT_EQ(bignum_cmp(&q, &a), EQUAL) TH_LOG("%d!", i);
+  }
+}
+
+TEST_F(bignum, decimal_input) {
+  enum { DIGITS = BN_ARRAY_SIZE * WORD_SIZE * 8 * 302 / 1000 + 2 }; /* room for the extra digit below */
+  struct bn a, b;
+  char buf[DIGITS];
+  int i, len;
+
+  EXPECT_EQ(bignum_from_decimal(&a, "1234567", 7), BN_OK);
+  EXPECT_EQ(bignum_to_int(&a), 1234567);
+  EXPECT_EQ(bignum_from_decimal(&a, "000", 3), BN_OK);
+  EXPECT_TRUE(bignum_is_zero(&a));
+  /* Only len characters are read */
+  EXPECT_EQ(bignum_from_decimal(&a, "42x", 2), BN_OK);
+  EXPECT_EQ(bignum_to_int(&a), 42);
+
+  EXPECT_EQ(bignum_from_decimal(&a, "", 0), BN_INVALID);
+  EXPECT_EQ(bignum_from_decimal(&a, "-1", 2), BN_INVALID);
+  EXPECT_EQ(bignum_from_decimal(&a, "12 3", 4), BN_INVALID);
+
+  /* 2^100 */
+  bignum_from_int(&b, 1);
+  bignum_lshift(&b, &b, 100);
+  EXPECT_EQ(bignum_from_decimal(&a, "1267650600228229401496703205376", 31), BN_OK);
+  EXPECT_EQ(bignum_cmp(&a, &b), EQUAL);
+
+  /* Round trips through bignum_to_decimal(), up to the largest value */
+  for (i = 0; i < 8; ++i) {
+    bignum_factorial(20 + 37 * i, &b);
+    bignum_dec(&b);
+    if (i == 7) {
+      bignum_init(&b);
+      bignum_dec(&b);
+    }
+    len = bignum_to_decimal(&b, buf, sizeof(buf));
+    EXPECT_EQ(bignum_from_decimal(&a, buf, len), BN_OK);
+    EXPECT_EQ(bignum_cmp(&a, &b), EQUAL) TH_LOG("%s", buf);
+  }
+
+  /* One more than the largest value, and ten times it */
+  buf[len - 1] += 1;
+  EXPECT_EQ(bignum_from_decimal(&a, buf, len), BN_OVERFLOW);
+  buf[len - 1] -= 1;
+  buf[len] = '0';
+  EXPECT_EQ(bignum_from_decimal(&a, buf, len + 1), BN_OVERFLOW);
+}
+
+TEST_F(bignum, radix) {
+  enum { DIGITS = BN_ARRAY_SIZE * WORD_SIZE * 8 + 2 }; /* base 2, with one digit too many */
+  struct bn a, b;
+  char buf[DIGITS];
+  int base, len;
+
+  bignum_from_int(&a, 1295);
+  EXPECT_EQ(bignum_to_radix(&a, buf, sizeof(buf), 36), 2);
+  EXPECT_STREQ("zz", buf);
+  EXPECT_EQ(bignum_to_radix(&a, buf, sizeof(buf), 2), 11);
+  EXPECT_STREQ("10100001111", buf);
+  EXPECT_EQ(bignum_to_radix(&a, buf, sizeof(buf), 64), 2);
+  EXPECT_STREQ("kf", buf);
+  EXPECT_EQ(bignum_to_radix(&a, buf, 2, 7), 4);
+  EXPECT_STREQ("3", buf);
+  bignum_init(&a);
+  EXPECT_EQ(bignum_to_radix(&a, buf, sizeof(buf), 58), 1);
+  EXPECT_STREQ("0", buf);
+
+  /* Case-insensitive up to base 36, case-sensitive above */
+  EXPECT_EQ(bignum_from_radix(&a, "ZZ", 2, 36), BN_OK);
+  EXPECT_EQ(bignum_to_int(&a), 1295);
+  EXPECT_EQ(bignum_from_radix(&a, "Zz", 2, 62), BN_OK);
+  EXPECT_EQ(bignum_to_int(&a), 61 * 62 + 35);
+  EXPECT_EQ(bignum_from_radix(&a, "12", 2, 2), BN_INVALID);
+  EXPECT_EQ(bignum_from_radix(&a, "", 0, 10), BN_INVALID);
+  EXPECT_EQ(bignum_from_radix(&a, "+/", 2, 63), BN_INVALID);
+
+  /* Bitcoin base58: no 0, O, I or l */
+  bignum_from_int(&a, 57);
+  EXPECT_EQ(bignum_to_base58(&a, buf, sizeof(buf)), 1);
+  EXPECT_STREQ("z", buf);
+  bignum_from_int(&a, 58);
+  bignum_to_base58(&a, buf, sizeof(buf));
+  EXPECT_STREQ("21", buf);
+  EXPECT_EQ(bignum_from_base58(&a, "0", 1), BN_INVALID);
+  EXPECT_EQ(bignum_from_base58(&a, "3yQ", 3), BN_OK);
+  EXPECT_EQ(bignum_to_int(&a), (2 * 58 + 56) * 58 + 23);
+
+  /* RFC 4648 base64 of the big-endian bytes "Man" */
+  bignum_from_int(&a, 0x4d616e);
+  EXPECT_EQ(bignum_to_base64(&a, buf, sizeof(buf)), 4);
+  EXPECT_STREQ("TWFu", buf);
+  bignum_from_int(&a, 0x4d61);
+  EXPECT_EQ(bignum_to_base64(&a, buf, sizeof(buf)), 4);
+  EXPECT_STREQ("TWE=", buf);
+  EXPECT_EQ(bignum_from_base64(&b, "TWE", 3), BN_OK);
+  EXPECT_EQ(bignum_cmp(&a, &b), EQUAL);
+  EXPECT_EQ(bignum_from_base64(&b, "AABNYQ==", 8), BN_OK);
+  EXPECT_EQ(bignum_cmp(&a, &b), EQUAL);
+  EXPECT_EQ(bignum_from_base64(&b, "T", 1), BN_INVALID);
+  EXPECT_EQ(bignum_from_base64(&b, "TW-u", 4), BN_INVALID);
+
+  /* Round trips of the largest value in every base, and one digit too many */
+  bignum_init(&b);
+  bignum_dec(&b);
+  for (base = 2; base <= 64; ++base) {
+    len = bignum_to_radix(&b, buf, sizeof(buf), base);
+    EXPECT_EQ(bignum_from_radix(&a, buf, len, base), BN_OK);
+    EXPECT_EQ(bignum_cmp(&a, &b), EQUAL) TH_LOG("base %d", base);
+    buf[len] = '1';
+    EXPECT_EQ(bignum_from_radix(&a, buf, len + 1, base), BN_OVERFLOW) TH_LOG("base %d", base);
+  }
+  len = bignum_to_base58(&b, buf, sizeof(buf));
+  EXPECT_EQ(bignum_from_base58(&a, buf, len), BN_OK);
+  EXPECT_EQ(bignum_cmp(&a, &b), EQUAL);
+  len = bignum_to_base64(&b, buf, sizeof(buf));
+  EXPECT_EQ(bignum_from_base64(&a, buf, len), BN_OK);
+  EXPECT_EQ(bignum_cmp(&a, &b), EQUAL);
+  /* 0x01 followed by more zero bytes than the width */
+  memcpy(buf, "AQAA", 4);
+  for (len = 4; len < 4 * ((int)sizeof(a.array) / 3 + 1); len += 4) {
+    memcpy(&buf[len], "AAAA", 4);
+  }
+  EXPECT_EQ(bignum_from_base64(&a, buf, len - 4), BN_OK);
+  EXPECT_EQ(bignum_from_base64(&a, buf, len), BN_OVERFLOW);
+}
+
+TEST_F(bignum, stream_reduce) {
+  struct bn x, m, expected, result, scale, ten;
+  struct bn_reducer r;
+  char text[1024];
+  uint8_t bytes[512];
+  char path[] = "/tmp/test-bignum-stream-XXXXXX";
+  int i, k, len, fds[2];
+
+  /* X = 300! - 1 against moduli from 10! + 1 up to 160! + 1 */
+  bignum_factorial(300, &x);
+  bignum_dec(&x);
+  len = bignum_to_decimal(&x, text, sizeof(text));
+  for (i = 1; i <= 16; i += 3) {
+    bignum_factorial(10 * i, &m);
+    bignum_inc(&m);
+    bignum_mod(&x, &m, &expected);
+
+    bn_reducer_init(&r, &m, 10);
+    EXPECT_EQ(bn_reducer_feed(&r, text, 7), BN_OK);
+    EXPECT_EQ(bn_reducer_feed(&r, "\n", 1), BN_OK);
+    EXPECT_EQ(bn_reducer_feed(&r, &text[7], len - 7), BN_OK);
+    EXPECT_EQ(bn_reducer_result(&r, &result), BN_OK);
+    EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL) TH_LOG("modulus %d! + 1", 10 * i);
+
+    /* The same digits twice: X * 10^len + X, wider than a struct bn */
+    EXPECT_EQ(bn_reducer_feed(&r, text, len), BN_OK);
+    bignum_from_int(&ten, 10);
+    bignum_from_int(&scale, 1);
+    for (k = 0; k < len; ++k) {
+      bignum_mul(&scale, &ten, &scale);
+      bignum_mod(&scale, &m, &scale);
+    }
+    bignum_mul(&expected, &scale, &scale);
+    bignum_add(&scale, &expected, &scale);
+    bignum_mod(&scale, &m, &expected);
+    EXPECT_EQ(bn_reducer_result(&r, &result), BN_OK);
+    EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL) TH_LOG("modulus %d! + 1, twice", 10 * i);
+  }
+
+  /* Hex and raw bytes, against a modulus of nearly the full width */
+  bignum_init(&m);
+  bignum_dec(&m);
+  bignum_rshift(&m, &m, 3);
+  bignum_mod(&x, &m, &expected);
+  len = bignum_to_string(&x, text, sizeof(text));
+  bn_reducer_init(&r, &m, 16);
+  EXPECT_EQ(bn_reducer_feed(&r, text, len), BN_OK);
+  EXPECT_EQ(bn_reducer_result(&r, &result), BN_OK);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+  len = bignum_nbytes(&x);
+  bignum_to_bytes_be(&x, bytes, len);
+  bn_reducer_init(&r, &m, BN_REDUCER_BYTES);
+  for (i = 0; i < len; ++i) {
+    EXPECT_EQ(bn_reducer_feed(&r, &bytes[i], 1), BN_OK);
+  }
+  EXPECT_EQ(bn_reducer_result(&r, &result), BN_OK);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+
+  /* A bad character sticks */
+  bn_reducer_init(&r, &m, 8);
+  EXPECT_EQ(bn_reducer_feed(&r, "1238", 4), BN_INVALID);
+  EXPECT_EQ(bn_reducer_feed(&r, "1", 1), BN_INVALID);
+  EXPECT_EQ(bn_reducer_result(&r, &result), BN_INVALID);
+
+  /* From a pipe and from a mapped file */
+  bignum_from_int(&m, 1000003);
+  bignum_mod(&x, &m, &expected);
+  len = bignum_to_decimal(&x, text, sizeof(text));
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], text, len), len);
+  close(fds[1]);
+  bn_reducer_init(&r, &m, 10);
+  EXPECT_EQ(bn_reducer_feed_fd(&r, fds[0]), BN_OK);
+  close(fds[0]);
+  bn_reducer_result(&r, &result);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+
+  int fd = mkstemp(path);
+  ASSERT_TRUE(fd >= 0);
+  ASSERT_EQ(write(fd, text, len), len);
+  close(fd);
+  bn_reducer_init(&r, &m, 10);
+  EXPECT_EQ(bn_reducer_feed_file(&r, path), BN_OK);
+  bn_reducer_result(&r, &result);
+  EXPECT_EQ(bignum_cmp(&result, &expected), EQUAL);
+  unlink(path);
+  EXPECT_EQ(bn_reducer_feed_file(&r, path), BN_IO_ERROR);
+}
+
+struct collect {
+  char text[1024];
+  int len;
+  int calls;
+  int fail_at;
+};
+
+static int collect_write(void* ctx, const char* text, int len) {
+  struct collect* c = (struct collect*)ctx;
+  c->calls += 1;
+  if (c->calls == c->fail_at)
+  {
+    return BN_IO_ERROR;
+  }
+  memcpy(&c->text[c->len], text, len);
+  c->len += len;
+  return BN_OK;
+}
+
+TEST_F(bignum, decimal_writer) {
+  enum { DIGITS = BN_ARRAY_SIZE * WORD_SIZE * 8 * 302 / 1000 + 2 };
+  struct bn a;
+  struct collect c;
+  char expected[DIGITS], buf[DIGITS];
+  int i, len, fds[2];
+  FILE* f;
+
+  for (i = 0; i <= 300; i += 20) {
+    bignum_factorial(i, &a);
+    len = bignum_to_decimal(&a, expected, sizeof(expected));
+    memset(&c, 0, sizeof(c));
+    EXPECT_EQ(bignum_write_decimal(&a, collect_write, &c), len);
+    EXPECT_EQ(c.len, len);
+    EXPECT_EQ(memcmp(c.text, expected, len), 0) TH_LOG("%d!", i);
+    EXPECT_TRUE(c.calls <= (len + BN_WRITE_BUFSIZE - 1) / BN_WRITE_BUFSIZE);
+  }
+
+  /* The writer's error comes back, and it is not called again */
+  bignum_init(&a);
+  bignum_dec(&a);
+  len = bignum_to_decimal(&a, expected, sizeof(expected));
+  memset(&c, 0, sizeof(c));
+  c.fail_at = 1;
+  EXPECT_EQ(bignum_write_decimal(&a, collect_write, &c), BN_IO_ERROR);
+  EXPECT_EQ(c.calls, 1);
+
+  /* To a pipe and to a FILE* */
+  ASSERT_EQ(pipe(fds), 0);
+  EXPECT_EQ(bn_write_decimal_fd(&a, fds[1]), len);
+  close(fds[1]);
+  EXPECT_EQ(read(fds[0], buf, sizeof(buf)), len);
+  close(fds[0]);
+  EXPECT_EQ(memcmp(buf, expected, len), 0);
+
+  f = tmpfile();
+  ASSERT_TRUE(f != NULL);
+  EXPECT_EQ(bn_write_decimal_stdio(&a, f), len);
+  rewind(f);
+  EXPECT_EQ((int)fread(buf, 1, sizeof(buf), f), len);
+  fclose(f);
+  EXPECT_EQ(memcmp(buf, expected, len), 0);
+}
+
+TEST_F(bignum, corpus) {
+  enum { COUNT = 40 };
+  struct bn records[COUNT];
+  struct bn_corpus c;
+  struct bn_corpus_writer w;
+  struct bn_corpus_header h;
+  char path[] = "/tmp/test-bignum-corpus-XXXXXX";
+  int i, fd;
+
+  for (i = 0; i < COUNT; ++i) {
+    bignum_factorial(5 * i, &records[i]);
+  }
+  fd = mkstemp(path);
+  ASSERT_TRUE(fd >= 0);
+  close(fd);
+
+  /* Written in two batches, read back in place */
+  ASSERT_EQ(bn_corpus_create(&w, path), BN_OK);
+  EXPECT_EQ(bn_corpus_append(&w, records, 15), BN_OK);
+  EXPECT_EQ(bn_corpus_append(&w, &records[15], COUNT - 15), BN_OK);
+  ASSERT_EQ(bn_corpus_finish(&w), BN_OK);
+  ASSERT_EQ(bn_corpus_open(&c, path), BN_OK);
+  ASSERT_EQ(c.count, COUNT);
+  EXPECT_EQ(((uintptr_t)c.records % BN_CORPUS_ALIGN), 0);
+  for (i = 0; i < COUNT; ++i) {
+    EXPECT_EQ(bignum_cmp(&c.records[i], &records[i]), EQUAL) TH_LOG("record %d", i);
+  }
+  bn_corpus_close(&c);
+
+  /* Another word size is refused */
+  fd = open(path, O_RDWR);
+  ASSERT_TRUE(fd >= 0);
+  ASSERT_EQ(read(fd, &h, sizeof(h)), sizeof(h));
+  h.word_size = (WORD_SIZE == 4) ? 2 : 4;
+  ASSERT_EQ(pwrite(fd, &h, sizeof(h), 0), sizeof(h));
+  close(fd);
+  EXPECT_EQ(bn_corpus_open(&c, path), BN_INVALID);
+
+  /* So is a record count the file is too short for */
+  ASSERT_EQ(bn_corpus_write(path, records, COUNT), BN_OK);
+  ASSERT_EQ(truncate(path, BN_CORPUS_ALIGN + (COUNT - 1) * sizeof(struct bn)), 0);
+  EXPECT_EQ(bn_corpus_open(&c, path), BN_INVALID);
+
+  /* Empty, and missing */
+  ASSERT_EQ(bn_corpus_write(path, NULL, 0), BN_OK);
+  ASSERT_EQ(bn_corpus_open(&c, path), BN_OK);
+  EXPECT_EQ(c.count, 0);
+  bn_corpus_close(&c);
+  unlink(path);
+  EXPECT_EQ(bn_corpus_open(&c, path), BN_IO_ERROR);
+}
+
+TEST_F(bignum, compact_store) {
+  enum { COUNT = 64 };
+  static DTYPE arena[BN_STORE_ARENA_LIMBS(COUNT, 8) + 2 * BN_ARRAY_SIZE];
+  static uint32_t slots[COUNT];
+  struct bn values[COUNT], deltas[COUNT], x, total;
+  bn_handle h[COUNT], d[COUNT];
+  struct bn_store s;
+  int i, round;
+
+  bn_store_init(&s, arena, sizeof(arena) / sizeof(arena[0]), slots, COUNT);
+
+  /* Half balances of a limb or two, half deltas; zero takes no limbs */
+  for (i = 0; i < COUNT / 2; ++i) {
+    bignum_from_int(&values[i], (DTYPE_TMP)i * 1000003);
+    bignum_from_int(&deltas[i], MAX_VAL - i);
+    ASSERT_EQ(bn_store_add(&s, &values[i], &h[i]), BN_OK);
+    ASSERT_EQ(bn_store_add(&s, &deltas[i], &d[i]), BN_OK);
+  }
+  EXPECT_EQ(bn_store_nlimbs(&s, h[0]), 0);
+  EXPECT_TRUE(bn_store_bytes(&s) < COUNT * sizeof(struct bn) / 4);
+
+  /* Balances grow past their blocks, move and get compacted along the way */
+  for (round = 0; round < 40; ++round) {
+    ASSERT_EQ(bn_store_add_many(&s, h, d, COUNT / 2), BN_OK);
+    for (i = 0; i < COUNT / 2; ++i) {
+      bignum_add(&values[i], &deltas[i], &values[i]);
+      bignum_lshift(&deltas[i], &deltas[i], 1);
+      ASSERT_EQ(bn_store_set(&s, d[i], &deltas[i]), BN_OK);
+    }
+  }
+  for (i = 0; i < COUNT / 2; ++i) {
+    bn_store_load(&s, h[i], &x);
+    EXPECT_EQ(bignum_cmp(&x, &values[i]), EQUAL) TH_LOG("value %d", i);
+  }
+
+  /* Sums agree, subtraction undoes the additions and wraps around like bignum_sub() */
+  bignum_init(&x);
+  for (i = 0; i < COUNT / 2; ++i) {
+    bignum_add(&x, &values[i], &x);
+  }
+  bn_store_sum(&s, h, COUNT / 2, &total);
+  EXPECT_EQ(bignum_cmp(&total, &x), EQUAL);
+
+  for (i = 0; i < COUNT / 2; ++i) {
+    bignum_rshift(&deltas[i], &deltas[i], 1);
+    ASSERT_EQ(bn_store_set(&s, d[i], &deltas[i]), BN_OK);
+  }
+  ASSERT_EQ(bn_store_sub_many(&s, h, d, COUNT / 2), BN_OK);
+  for (i = 0; i < COUNT / 2; ++i) {
+    bignum_sub(&values[i], &deltas[i], &values[i]);
+    bn_store_load(&s, h[i], &x);
+    EXPECT_EQ(bignum_cmp(&x, &values[i]), EQUAL) TH_LOG("value %d", i);
+  }
+  ASSERT_EQ(bn_store_sub_many(&s, h, d, 1), BN_OK);
+  bignum_sub(&values[0], &deltas[0], &values[0]);
+  bn_store_load(&s, h[0], &x);
+  EXPECT_EQ(bignum_cmp(&x, &values[0]), EQUAL);
+  EXPECT_EQ(bn_store_nlimbs(&s, h[0]), BN_ARRAY_SIZE);
+  ASSERT_EQ(bn_store_sub_many(&s, h, h, 1), BN_OK);
+  EXPECT_EQ(bn_store_nlimbs(&s, h[0]), 0);
+
+  /* A store that is full leaves the value alone */
+  bn_store_compact(&s);
+  EXPECT_EQ(s.garbage, 0);
+  bignum_init(&x);
+  bignum_dec(&x);
+  for (i = 0; i < COUNT / 2; ++i) {
+    if (bn_store_set(&s, d[i], &x) != BN_OK) {
+      break;
+    }
+  }
+  ASSERT_TRUE(i < COUNT / 2);
+  bn_store_load(&s, d[i], &x);
+  EXPECT_EQ(bignum_cmp(&x, &deltas[i]), EQUAL);
+}
+
+TEST_F(bignum, gcd_inverse) {
+  struct bn a, b, g, x, y, m, inv, t, expected, one;
+  char buf[1024];
+  int i;
+
+  bignum_from_int(&one, 1);
+
+  /* gcd(100!, 2^90 * 3^5) = 2^90 * 3^5, gcd(0, b) = b, gcd(0, 0) = 0 */
+  bignum_factorial(100, &a);
+  bignum_from_int(&b, 243);
+  bignum_lshift(&b, &b, 90);
+  bignum_gcd(&a, &b, &g);
+  EXPECT_EQ(bignum_cmp(&g, &b), EQUAL);
+  bignum_init(&a);
+  bignum_gcd(&a, &b, &g);
+  EXPECT_EQ(bignum_cmp(&g, &b), EQUAL);
+  bignum_gcd(&a, &a, &g);
+  EXPECT_TRUE(bignum_is_zero(&g));
+
+  /* Consecutive Fibonacci numbers are coprime, with the worst case for Euclid */
+  bignum_from_int(&a, 1);
+  bignum_from_int(&b, 1);
+  for (i = 0; i < (BN_ARRAY_SIZE * WORD_SIZE * 8) / 3; ++i) {
+    bignum_add(&a, &b, &t);
+    bignum_assign(&a, &b);
+    bignum_assign(&b, &t);
+  }
+  bignum_gcd(&a, &b, &g);
+  EXPECT_EQ(bignum_cmp(&g, &one), EQUAL);
+
+  /* gcd(F(1800), F(1200)) = F(600), at some 1250 bits well into Lehmer's algorithm */
+  bignum_init(&x);
+  bignum_from_int(&y, 1);
+  for (i = 1; i <= 1800; ++i) {
+    bignum_add(&x, &y, &t);
+    bignum_assign(&x, &y);
+    bignum_assign(&y, &t);
+    if (i == 600) {
+      bignum_assign(&expected, &x);
+    }
+    if (i == 1200) {
+      bignum_assign(&m, &x);
+    }
+  }
+  bignum_gcd(&x, &m, &g);
+  EXPECT_EQ(bignum_cmp(&g, &expected), EQUAL);
+
+  /* a * x - b * y = gcd(a, b) = 40! + 1, with a and b under half the width */
+  bignum_factorial(40, &t);
+  bignum_inc(&t);
+  bignum_mul(&a, &t, &a);
+  bignum_mul(&b, &t, &b);
+  bignum_gcdext(&a, &b, &g, &x, &y);
+  bignum_mul(&a, &x, &t);
+  bignum_mul(&b, &y, &expected);
+  bignum_sub(&t, &expected, &t);
+  EXPECT_EQ(bignum_cmp(&t, &g), EQUAL);
+  bignum_factorial(40, &t);
+  bignum_inc(&t);
+  EXPECT_EQ(bignum_cmp(&t, &g), EQUAL);
+
+  /* RSA: d = e^-1 mod (p-1)(q-1), with an even modulus, and e * d == 1 */
+  bignum_from_string(&m, "d5b3b4e8a6ad9f6b9c0f4b8ed9f0a2c4e1f8a7b6c5d4e3f2a1b0c9d8e7f6a5b4", 64);
+  bignum_from_int(&a, 65537);
+  EXPECT_EQ(bignum_modinv(&a, &m, &inv), BN_OK);
+  bignum_mul(&a, &inv, &t);
+  bignum_mod(&t, &m, &t);
+  EXPECT_EQ(bignum_cmp(&t, &one), EQUAL);
+  EXPECT_EQ(bignum_cmp(&inv, &m), SMALLER);
+
+  /* Odd modulus, a larger than m, and a power of two */
+  bignum_from_int(&m, 1000003);
+  bignum_factorial(30, &a);
+  EXPECT_EQ(bignum_modinv(&a, &m, &inv), BN_OK);
+  bignum_to_string(&inv, buf, sizeof(buf));
+  EXPECT_STREQ("9f59f", buf);
+  bignum_from_int(&m, 1);
+  bignum_lshift(&m, &m, 200);
+  bignum_from_int(&a, 3);
+  EXPECT_EQ(bignum_modinv(&a, &m, &inv), BN_OK);
+  bignum_mul(&a, &inv, &t);
+  bignum_mod(&t, &m, &t);
+  EXPECT_EQ(bignum_cmp(&t, &one), EQUAL);
+
+  /* No inverse without coprimality; modulo one everything is zero */
+  bignum_from_int(&a, 6);
+  bignum_from_int(&m, 1000002);
+  EXPECT_EQ(bignum_modinv(&a, &m, &inv), BN_INVALID);
+  bignum_from_int(&m, 999999);
+  EXPECT_EQ(bignum_modinv(&a, &m, &inv), BN_INVALID);
+  EXPECT_EQ(bignum_modinv(&a, &one, &inv), BN_OK);
+  EXPECT_TRUE(bignum_is_zero(&inv));
+}
+
+TEST_F(bignum, batch_inverse) {
+  struct bn in[16], out[16], m, inv, t;
+  int i;
+
+  /* Modulo the prime 2^127 - 1 every nonzero element has an inverse */
+  bignum_from_int(&m, 1);
+  bignum_lshift(&m, &m, 127);
+  bignum_dec(&m);
+  for (i = 0; i < 16; ++i) {
+    bignum_factorial(i + 20, &in[i]);
+    bignum_mod(&in[i], &m, &in[i]);
+  }
+  EXPECT_EQ(bignum_modinv_batch(in, out, 16, &m), BN_OK);
+  for (i = 0; i < 16; ++i) {
+    EXPECT_EQ(bignum_modinv(&in[i], &m, &inv), BN_OK);
+    EXPECT_EQ(bignum_cmp(&out[i], &inv), EQUAL);
+  }
+
+  /* A single element, and nothing at all */
+  EXPECT_EQ(bignum_modinv_batch(&in[3], out, 1, &m), BN_OK);
+  bignum_modinv(&in[3], &m, &inv);
+  EXPECT_EQ(bignum_cmp(&out[0], &inv), EQUAL);
+  EXPECT_EQ(bignum_modinv_batch(in, out, 0, &m), BN_OK);
+
+  /* One element without an inverse fails the whole batch */
+  bignum_from_int(&m, 1000);
+  for (i = 0; i < 4; ++i) {
+    bignum_from_int(&in[i], 3 + 2 * i);
+  }
+  EXPECT_EQ(bignum_modinv_batch(in, out, 4, &m), BN_INVALID);
+  bignum_from_int(&in[1], 7);
+  EXPECT_EQ(bignum_modinv_batch(in, out, 4, &m), BN_OK);
+  for (i = 0; i < 4; ++i) {
+    bignum_mul(&in[i], &out[i], &t);
+    bignum_mod(&t, &m, &t);
+    EXPECT_EQ(bignum_to_int(&t), 1);
+  }
+}
+
+TEST_F(bignum, primality) {
+  enum { JOBS = 8 };
+  /* Mersenne primes, a semiprime of two of them, Carmichael numbers and strong pseudoprimes to small bases */
+  static const struct { const char* hex; int prime; } cases[] = {
+    { "02", 1 }, { "03", 1 }, { "01", 0 }, { "00", 0 }, { "0f", 0 }, { "0f4243", 1 },
+    { "0231", 0 },                                  /* 561 = 3 * 11 * 17 */
+    { "bfa17dc7", 0 },                              /* 3215031751: bases 2, 3, 5, 7 */
+    { "351591274f9af9fb", 0 },                      /* 3825123056546413051: bases 2 .. 23 */
+    { "1fffffffffffffff", 1 },                      /* 2^61 - 1 */
+    { "7fffffffffffffffffffffffffffffff", 1 },      /* 2^127 - 1 */
+    { "3ffffffffffffffdffffffe000000000000001", 0 }, /* (2^61 - 1)(2^89 - 1) */
+  };
+  struct bn_pool pool;
+  struct bn n[JOBS], a;
+  int res[JOBS];
+  int i;
+
+  for (i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); ++i) {
+    ASSERT_EQ(bignum_from_string(&a, cases[i].hex, strlen(cases[i].hex)), BN_OK);
+    EXPECT_EQ(bignum_is_probable_prime(&a), cases[i].prime) TH_LOG("%s", cases[i].hex);
+  }
+
+  /* 2^521 - 1 is prime, 2^523 - 1 is not; squares of primes fail the Lucas test */
+  bignum_from_int(&a, 1);
+  bignum_lshift(&a, &a, 521);
+  bignum_dec(&a);
+  EXPECT_EQ(bignum_is_probable_prime(&a), 1);
+  bignum_from_int(&a, 1);
+  bignum_lshift(&a, &a, 523);
+  bignum_dec(&a);
+  EXPECT_EQ(bignum_is_probable_prime(&a), 0);
+  bignum_from_int(&a, 1);
+  bignum_lshift(&a, &a, 127);
+  bignum_dec(&a);
+  bignum_mul(&a, &a, &a);
+  EXPECT_EQ(bignum_is_probable_prime(&a), 0);
+
+  /* (1001/9907) = -1, (19/45) = 1, (6/15) = 0 */
+  bignum_from_int(&a, 1001);
+  bignum_from_int(&n[0], 9907);
+  EXPECT_EQ(bignum_jacobi(&a, &n[0]), -1);
+  bignum_from_int(&a, 19);
+  bignum_from_int(&n[0], 45);
+  EXPECT_EQ(bignum_jacobi(&a, &n[0]), 1);
+  bignum_from_int(&a, 6);
+  bignum_from_int(&n[0], 15);
+  EXPECT_EQ(bignum_jacobi(&a, &n[0]), 0);
+
+  /* 2^127 - 1 + 2i for i < JOBS: only i = 0 is prime */
+  ASSERT_EQ(bn_pool_init(&pool, 3), 0);
+  for (i = 0; i < JOBS; ++i) {
+    bignum_from_int(&n[i], 1);
+    bignum_lshift(&n[i], &n[i], 127);
+    bignum_dec(&n[i]);
+    bignum_from_int(&a, 2 * i);
+    bignum_add(&n[i], &a, &n[i]);
+  }
+  bignum_is_probable_prime_many(&pool, n, res, JOBS);
+  for (i = 0; i < JOBS; ++i) {
+    EXPECT_EQ(res[i], bignum_is_probable_prime(&n[i])) TH_LOG("job %d", i);
+  }
+  EXPECT_EQ(res[0], 1);
+  bn_pool_destroy(&pool);
+}
+
+/* Deterministic bytes for bignum_gen_prime(), failing once the budget runs out */
+struct byte_source {
+  uint32_t state;
+  size_t budget;
+};
+
+static int byte_source_fill(void* ctx, uint8_t* buf, size_t len) {
+  struct byte_source* src = ctx;
+  size_t i;
+  if (len > src->budget) {
+    return BN_IO_ERROR;
+  }
+  src->budget -= len;
+  for (i = 0; i < len; ++i) {
+    src->state = src->state * 1103515245u + 12345u;
+    buf[i] = (uint8_t)(src->state >> 16);
+  }
+  return BN_OK;
+}
+
+TEST_F(bignum, prime_search) {
+  struct byte_source src = { 1, 100000 };
+  struct bn a, p, t;
+  char buf[64];
+  int i;
+
+  /* Small numbers: 0 -> 2, 7 -> 11, across the sieve limit */
+  bignum_init(&a);
+  EXPECT_EQ(bignum_next_prime(&a, &p), BN_OK);
+  EXPECT_EQ(bignum_to_int(&p), 2);
+  bignum_from_int(&a, 7);
+  bignum_next_prime(&a, &p);
+  EXPECT_EQ(bignum_to_int(&p), 11);
+  bignum_from_int(&a, 8190);
+  bignum_next_prime(&a, &p);
+  EXPECT_EQ(bignum_to_int(&p), 8191);
+  bignum_next_prime(&p, &p);
+  EXPECT_EQ(bignum_to_int(&p), 8209);
+
+  /* 2^64 + 13 is the first prime above 2^64, 2^127 - 1 the first above the prime 2^127 - 25 */
+  bignum_from_int(&a, 1);
+  bignum_lshift(&a, &a, 64);
+  EXPECT_EQ(bignum_next_prime(&a, &p), BN_OK);
+  bignum_sub(&p, &a, &t);
+  EXPECT_EQ(bignum_to_int(&t), 13);
+  bignum_from_int(&a, 1);
+  bignum_lshift(&a, &a, 127);
+  bignum_from_int(&t, 25);
+  bignum_sub(&a, &t, &a);
+  bignum_next_prime(&a, &p);
+  bignum_to_string(&p, buf, sizeof(buf));
+  EXPECT_STREQ("7fffffffffffffffffffffffffffffff", buf);
+
+  /* Nothing fits above the largest number */
+  bignum_init(&a);
+  bignum_dec(&a);
+  EXPECT_EQ(bignum_next_prime(&a, &p), BN_OVERFLOW);
+
+  /* Random primes of exactly nbits bits, the top two set */
+  for (i = 2; i < 200; i += 37) {
+    ASSERT_EQ(bignum_gen_prime(&p, i, byte_source_fill, &src), BN_OK);
+    EXPECT_TRUE(bignum_is_probable_prime(&p));
+    bignum_rshift(&p, &t, i - 2);
+    EXPECT_EQ(bignum_to_int(&t), 3) TH_LOG("%d bits", i);
+  }
+  EXPECT_EQ(bignum_gen_prime(&p, 1, byte_source_fill, &src), BN_INVALID);
+  src.budget = 0;
+  EXPECT_EQ(bignum_gen_prime(&p, 64, byte_source_fill, &src), BN_IO_ERROR);
+}
+
+TEST_F(bignum, rsa_keygen) {
+  struct bn_pool pool, single, wide;
+  struct bn_rsa_key key, other;
+  struct bn m, c, t, one;
+  int nbits, seed;
+
+  bignum_from_int(&one, 1);
+  ASSERT_EQ(bn_pool_init(&pool, 3), 0);
+  ASSERT_EQ(bn_pool_init(&single, 1), 0);
+
+  for (nbits = 301; nbits <= 512; nbits += 211) {
+    /* The same seed gives the same key, whatever the number of threads */
+    ASSERT_EQ(bn_rsa_keygen_seeded(&pool, &key, nbits, 65537, 42), BN_OK);
+    ASSERT_EQ(bn_rsa_keygen_seeded(NULL, &other, nbits, 65537, 42), BN_OK);
+    EXPECT_EQ(bignum_cmp(&key.n, &other.n), EQUAL);
+    EXPECT_EQ(bignum_cmp(&key.d, &other.d), EQUAL);
+
+    /* n = p * q of exactly nbits bits, with p > q both prime */
+    bignum_rshift(&key.n, &t, nbits - 1);
+    EXPECT_EQ(bignum_cmp(&t, &one), EQUAL) TH_LOG("%d bits", nbits);
+    bignum_mul(&key.p, &key.q, &t);
+    EXPECT_EQ(bignum_cmp(&t, &key.n), EQUAL);
+    EXPECT_EQ(bignum_cmp(&key.p, &key.q), LARGER);
+    EXPECT_TRUE(bignum_is_probable_prime(&key.p));
+    EXPECT_TRUE(bignum_is_probable_prime(&key.q));
+
+    /* e * dp = 1 mod p - 1, e * dq = 1 mod q - 1, q * qinv = 1 mod p */
+    bignum_mul(&key.e, &key.dp, &t);
+    bignum_dec(&key.p);
+    bignum_mod(&t, &key.p, &t);
+    bignum_inc(&key.p);
+    EXPECT_EQ(bignum_cmp(&t, &one), EQUAL);
+    bignum_mul(&key.e, &key.dq, &t);
+    bignum_dec(&key.q);
+    bignum_mod(&t, &key.q, &t);
+    bignum_inc(&key.q);
+    EXPECT_EQ(bignum_cmp(&t, &one), EQUAL);
+    bignum_mul(&key.q, &key.qinv, &t);
+    bignum_mod(&t, &key.p, &t);
+    EXPECT_EQ(bignum_cmp(&t, &one), EQUAL);
+
+    /* The CRT private operation undoes the public one, and agrees with c^d mod n */
+    bignum_from_int(&m, 0x1234567);
+    bignum_mul(&m, &m, &m);
+    bn_rsa_public(&key, &m, &c);
+    bn_rsa_private(&key, &c, &t);
+    EXPECT_EQ(bignum_cmp(&t, &m), EQUAL);
+    bignum_pow_mod(&c, &key.d, &key.n, &t);
+    EXPECT_EQ(bignum_cmp(&t, &m), EQUAL);
+  }
+
+  /* Small keys, where the searches often run past nbits bits and start over */
+  ASSERT_EQ(bn_pool_init(&wide, 16), 0);
+  for (nbits = 16; nbits <= 24; ++nbits) {
+    for (seed = 0; seed < 40; ++seed) {
+      ASSERT_EQ(bn_rsa_keygen_seeded(NULL, &key, nbits, 3, seed), BN_OK);
+      ASSERT_EQ(bn_rsa_keygen_seeded(&single, &other, nbits, 3, seed), BN_OK);
+      EXPECT_EQ(bignum_cmp(&key.n, &other.n), EQUAL) TH_LOG("%d bits, seed %d", nbits, seed);
+      ASSERT_EQ(bn_rsa_keygen_seeded(&wide, &other, nbits, 3, seed), BN_OK);
+      EXPECT_EQ(bignum_cmp(&key.n, &other.n), EQUAL) TH_LOG("%d bits, seed %d", nbits, seed);
+    }
+  }
+  bn_pool_destroy(&wide);
+
+  /* Another seed, another key; no key below 16 bits or with an even e */
+  ASSERT_EQ(bn_rsa_keygen_seeded(&pool, &other, 512, 65537, 43), BN_OK);
+  EXPECT_NE(bignum_cmp(&key.n, &other.n), EQUAL);
+  EXPECT_EQ(bn_rsa_keygen_seeded(&pool, &other, 15, 65537, 1), BN_INVALID);
+  EXPECT_EQ(bn_rsa_keygen_seeded(&pool, &other, 512, 65536, 1), BN_INVALID);
+
+  bn_pool_destroy(&single);
+  bn_pool_destroy(&pool);
+}
+
+TEST_F(bignum, modular_sums) {
+  struct bn m, a, b, c, expect, t;
+  int i, j;
+
+  /* Against plain add, sub and mod for residues of 2^127 - 1, including 0 and m - 1 */
+  bignum_from_int(&m, 1);
+  bignum_lshift(&m, &m, 127);
+  bignum_dec(&m);
+  for (i = 0; i < 8; ++i) {
+    bignum_factorial(3 * i + 10, &a);
+    bignum_mod(&a, &m, &a);
+    if (i == 0) {
+      bignum_init(&a);
+    }
+    if (i == 1) {
+      bignum_assign(&a, &m);
+      bignum_dec(&a);
+    }
+    for (j = 0; j < 8; ++j) {
+      bignum_factorial(5 * j + 12, &t);
+      bignum_mod(&t, &m, &b);
+
+      bignum_add(&a, &b, &expect);
+      bignum_mod(&expect, &m, &expect);
+      bignum_mod_add(&a, &b, &m, &c);
+      EXPECT_EQ(bignum_cmp(&c, &expect), EQUAL);
+
+      bignum_add(&a, &m, &expect);
+      bignum_sub(&expect, &b, &expect);
+      bignum_mod(&expect, &m, &expect);
+      bignum_mod_sub(&a, &b, &m, &c);
+      EXPECT_EQ(bignum_cmp(&c, &expect), EQUAL);
+    }
+    bignum_mod_neg(&a, &m, &c);
+    bignum_mod_add(&a, &c, &m, &c);
+    EXPECT_TRUE(bignum_is_zero(&c));
+
+    bignum_mod_dbl(&a, &m, &c);
+    bignum_mod_add(&a, &a, &m, &expect);
+    EXPECT_EQ(bignum_cmp(&c, &expect), EQUAL);
+  }
+
+  /* The sum carries out of the top limb when m fills the whole width */
+  bignum_init(&m);
+  bignum_dec(&m);
+  bignum_assign(&a, &m);
+  bignum_dec(&a);
+  bignum_mod_dbl(&a, &m, &c);
+  bignum_assign(&expect, &a);
+  bignum_dec(&expect);
+  EXPECT_EQ(bignum_cmp(&c, &expect), EQUAL);
+  bignum_from_int(&b, 5);
+  bignum_mod_sub(&b, &a, &m, &c);
+  bignum_from_int(&expect, 6);
+  EXPECT_EQ(bignum_cmp(&c, &expect), EQUAL);
+
+  /* Outputs may alias inputs, and limbs above m are cleared */
+  bignum_from_int(&m, 1000003);
+  bignum_from_int(&a, 999999);
+  bignum_mod_add(&a, &a, &m, &a);
+  EXPECT_EQ(bignum_to_int(&a), 999995);
+  bignum_mod_sub(&a, &a, &m, &a);
+  EXPECT_TRUE(bignum_is_zero(&a));
+  bignum_from_int(&a, 1);
+  bignum_mod_neg(&a, &m, &a);
+  EXPECT_EQ(bignum_to_int(&a), 1000002);
+}
+
+TEST_F(bignum, montgomery_chain) {
+  struct bn_mont ctx;
+  struct bn m, a, b, x, y, z, expect, t;
+  int i;
+
+  /* Even moduli and 1 have no Montgomery form */
+  bignum_from_int(&m, 1000);
+  EXPECT_EQ(bignum_mont_init(&ctx, &m), BN_INVALID);
+  bignum_from_int(&m, 1);
+  EXPECT_EQ(bignum_mont_init(&ctx, &m), BN_INVALID);
+
+  /* Horner's rule for p(a) = a^16 + b * (a^15 + ... + a + 1) - a mod 2^127 - 1, converting only at the ends */
+  bignum_from_int(&m, 1);
+  bignum_lshift(&m, &m, 127);
+  bignum_dec(&m);
+  EXPECT_EQ(bignum_mont_init(&ctx, &m), BN_OK);
+  EXPECT_EQ(ctx.lazy, 1);
+  bignum_factorial(40, &a);
+  bignum_factorial(33, &b);
+  bignum_mod(&b, &m, &b);
+  bignum_to_mont(&a, &ctx, &x);
+  bignum_to_mont(&b, &ctx, &y);
+  bignum_mod(&a, &m, &a);
+  bignum_assign(&z, &y);
+  bignum_assign(&expect, &b);
+  for (i = 0; i < 15; ++i) {
+    bignum_mont_mul(&z, &x, &ctx, &z);
+    bignum_mont_add(&z, &y, &ctx, &z);
+    bignum_mul(&expect, &a, &t);
+    bignum_add(&t, &b, &t);
+    bignum_mod(&t, &m, &expect);
+  }
+  bignum_mont_sqr(&x, &ctx, &t);
+  for (i = 0; i < 3; ++i) {
+    bignum_mont_sqr(&t, &ctx, &t);
+  }
+  bignum_mont_add(&z, &t, &ctx, &z);
+  bignum_mont_sub(&z, &x, &ctx, &z);
+  bignum_from_mont(&z, &ctx, &z);
+
+  bignum_from_int(&t, 16);
+  bignum_pow_mod(&a, &t, &m, &t);
+  bignum_add(&expect, &t, &expect);
+  bignum_add(&expect, &m, &expect);
+  bignum_sub(&expect, &a, &expect);
+  bignum_mod(&expect, &m, &expect);
+  EXPECT_EQ(bignum_cmp(&z, &expect), EQUAL);
+
+  /* m with its top bits set takes a wider R; 0 and m - 1 convert back exactly */
+  bignum_from_int(&m, 0xffff);
+  bignum_lshift(&m, &m, 112);
+  bignum_inc(&m);
+  EXPECT_EQ(bignum_mont_init(&ctx, &m), BN_OK);
+  EXPECT_EQ(ctx.nlimbs, 128 / (8 * WORD_SIZE) + 1);
+  bignum_init(&a);
+  bignum_to_mont(&a, &ctx, &x);
+  bignum_from_mont(&x, &ctx, &z);
+  EXPECT_TRUE(bignum_is_zero(&z));
+  bignum_assign(&a, &m);
+  bignum_dec(&a);
+  bignum_to_mont(&a, &ctx, &x);
+  bignum_mont_sqr(&x, &ctx, &x);
+  bignum_from_mont(&x, &ctx, &z);
+  EXPECT_EQ(bignum_to_int(&z), 1);
+}
+
+TEST_F(bignum, modulus_cache) {
+  enum { JOBS = 64 };
+  static const int exponents[4] = { 127, 89, 61, 107 };
+  struct bn_pool pool;
+  struct bn a[JOBS], b[JOBS], n[JOBS], c[JOBS], m, e, x, first;
+  unsigned long hits, misses;
+  int i;
+
+  bignum_modcache_clear();
+  bignum_modcache_stats(&hits, &misses);
+  EXPECT_EQ(hits, 0);
+  EXPECT_EQ(misses, 0);
+
+  /* The second exponentiation by 2^127 - 1 reuses its context, and gets the same answer */
+  bignum_from_int(&m, 1);
+  bignum_lshift(&m, &m, 127);
+  bignum_dec(&m);
+  bignum_factorial(30, &x);
+  bignum_factorial(31, &e);
+  bignum_pow_mod(&x, &e, &m, &first);
+  bignum_pow_mod(&x, &e, &m, &c[0]);
+  EXPECT_EQ(bignum_cmp(&c[0], &first), EQUAL);
+  bignum_modcache_stats(&hits, &misses);
+  if (BN_MODCACHE_SIZE == 0) {
+    return;
+  }
+  EXPECT_EQ(hits, 1);
+  EXPECT_EQ(misses, 1);
+
+  /* Even moduli have nothing to cache */
+  bignum_from_int(&n[0], 1000);
+  bignum_pow_mod(&x, &e, &n[0], &c[0]);
+  bignum_modcache_stats(&hits, &misses);
+  EXPECT_EQ(hits + misses, 2);
+
+  /* Filling the cache evicts the least recently used modulus */
+  bignum_assign(&n[0], &m);
+  for (i = 1; i < BN_MODCACHE_SIZE; ++i) {
+    bignum_inc(&n[0]);
+    bignum_inc(&n[0]);
+    bignum_pow_mod(&x, &e, &n[0], &c[0]);
+  }
+  bignum_pow_mod(&x, &e, &m, &c[0]);
+  bignum_modcache_stats(&hits, &misses);
+  EXPECT_EQ(hits, 2);
+  bignum_inc(&n[0]);
+  bignum_inc(&n[0]);
+  bignum_pow_mod(&x, &e, &n[0], &c[0]);
+  bignum_assign(&n[1], &m);
+  bignum_inc(&n[1]);
+  bignum_inc(&n[1]);
+  bignum_pow_mod(&x, &e, &n[1], &c[0]);
+  bignum_pow_mod(&x, &e, &m, &c[0]);
+  EXPECT_EQ(bignum_cmp(&c[0], &first), EQUAL);
+  bignum_modcache_stats(&hits, &misses);
+  EXPECT_EQ(hits, 3);
+  EXPECT_EQ(misses, BN_MODCACHE_SIZE + 2);
+
+  /* Threads sharing a few Mersenne primes p: a^(p - 1) = 1 whichever thread filled the cache */
+  ASSERT_EQ(bn_pool_init(&pool, 3), 0);
+  bignum_modcache_clear();
+  for (i = 0; i < JOBS; ++i) {
+    bignum_from_int(&n[i], 1);
+    bignum_lshift(&n[i], &n[i], exponents[i % 4]);
+    bignum_dec(&n[i]);
+    bignum_assign(&b[i], &n[i]);
+    bignum_dec(&b[i]);
+    bignum_from_int(&a[i], i + 2);
+  }
+  bignum_pow_mod_many(&pool, a, b, n, c, JOBS);
+  for (i = 0; i < JOBS; ++i) {
+    EXPECT_EQ(bignum_to_int(&c[i]), 1) TH_LOG("pow_mod %d", i);
+  }
+  bignum_modcache_stats(&hits, &misses);
+  EXPECT_EQ(hits + misses, JOBS);
+  EXPECT_GE(misses, 4);
+  bn_pool_destroy(&pool);
+}
+
+TEST_F(bignum, word_exponent) {
+  static const DTYPE_TMP exponents[] = { 0, 1, 2, 3, 17, 65537, 0x80000001, MAX_VAL };
+  struct bn a, n, e, expect, res;
+  int i, k;
+
+  for (k = 0; k < 4; ++k) {
+    /* Odd, odd and narrower than a, even, and 1 */
+    bignum_factorial(35 + k, &n);
+    if (k < 2) {
+      bignum_inc(&n);
+    }
+    if (k == 3) {
+      bignum_from_int(&n, 1);
+    }
+    bignum_factorial(34 + 3 * k, &a);
+    bignum_dec(&a);
+    for (i = 0; i < (int)(sizeof(exponents) / sizeof(*exponents)); ++i) {
+      bignum_from_int(&e, exponents[i]);
+      bignum_pow_mod(&a, &e, &n, &expect);
+      bignum_pow_mod_word(&a, exponents[i], &n, &res);
+      EXPECT_EQ(bignum_cmp(&res, &expect), EQUAL) TH_LOG("modulus %d, exponent %d", k, i);
+    }
+  }
+
+  /* 2^65537 mod 2^127 - 1 = 2^(65537 mod 127) */
+  bignum_from_int(&n, 1);
+  bignum_lshift(&n, &n, 127);
+  bignum_dec(&n);
+  bignum_from_int(&a, 2);
+  bignum_pow_mod_word(&a, 65537, &n, &res);
+  bignum_from_int(&expect, 1);
+  bignum_lshift(&expect, &expect, 65537 % 127);
+  EXPECT_EQ(bignum_cmp(&res, &expect), EQUAL);
+}
+
 int test_bignum_main(int argc, char **argv) {
   printf("WORD_SIZE = %d\n", (int)WORD_SIZE);
   printf("BN_ARRAY_SIZE = %d\n", (int)BN_ARRAY_SIZE);